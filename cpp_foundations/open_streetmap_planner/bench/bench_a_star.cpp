@@ -0,0 +1,111 @@
+#include <benchmark/benchmark.h>
+#include <optional>
+#include "bench_common.h"
+#include "../src/route_planner.h"
+
+// Snapping a point to the nearest road node, a linear scan over all road nodes.
+static void BM_FindClosestNode(benchmark::State &state, bool largest_component_only) {
+    RouteModel &model = bench::SharedModel();
+    const auto queries = bench::RandomQueries(64);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto &query = queries[i++ % queries.size()];
+        auto &node = model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f, largest_component_only);
+        benchmark::DoNotOptimize(&node);
+    }
+}
+BENCHMARK_CAPTURE(BM_FindClosestNode, AllRoads, false);
+BENCHMARK_CAPTURE(BM_FindClosestNode, LargestComponent, true);
+
+// One expansion of the legacy A*: AddNeighbors() on a road node and NextNode() until the open
+// list is empty again, so the sort always sees a short list.
+static void BM_AddNeighbors(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    RoutePlanner planner{model, 10, 10, 90, 90};
+    const auto queries = bench::RandomQueries(64);
+    std::vector<RouteModel::Node *> nodes;
+    for (const auto &query : queries) {
+        nodes.push_back(&model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f));
+    }
+
+    std::size_t i = 0;
+    double neighbors = 0;
+    for (auto _ : state) {
+        RouteModel::Node *node = nodes[i++ % nodes.size()];
+        model.NewSearch();
+        node->Refresh();
+        node->visited = true;
+        planner.AddNeighbors(node);
+        neighbors += node->neighbors.size();
+        while (planner.NextNode()) {
+        }
+    }
+    state.counters["neighbors"] = benchmark::Counter(neighbors, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_AddNeighbors);
+
+// NextNode() sorts the whole open list for every node it returns, so its cost grows with the
+// open list. The list is filled with the neighbors of road nodes in index order until it holds
+// state.range(0) entries or every road node was expanded.
+static void BM_NextNode(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    const auto &graph = model.Graph().Forward();
+    std::vector<RouteModel::Node *> nodes;
+    for (int v = 0; v < model.Graph().NodeCount(); ++v) {
+        if (graph.Begin(v) != graph.End(v)) {
+            nodes.push_back(&model.SNodes()[v]);
+        }
+    }
+    std::optional<RoutePlanner> planner;
+    double open_list = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        // A new planner starts with an empty open list.
+        planner.emplace(model, 10, 10, 90, 90);
+        model.NewSearch();
+        int pushed = 0;
+        for (std::size_t j = 0; j < nodes.size() && pushed < state.range(0); ++j) {
+            const auto before = planner->Stats().heap_pushes;
+            nodes[j]->Refresh();
+            nodes[j]->visited = true;
+            planner->AddNeighbors(nodes[j]);
+            pushed += planner->Stats().heap_pushes - before;
+        }
+        open_list += pushed;
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(planner->NextNode());
+    }
+    state.counters["open_list"] = benchmark::Counter(open_list, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_NextNode)->RangeMultiplier(4)->Range(16, 4096);
+
+// The full legacy AStarSearch() on a set of query endpoints, with snapping kept out of the
+// timing. The counters are the search work reported by Stats().
+static void BM_AStarSearch(benchmark::State &state, std::vector<bench::Query> queries) {
+    RouteModel &model = bench::SharedModel();
+    RoutePlanner planner{model, 0, 0, 0, 0};
+    bench::SilenceStdout silence;
+
+    std::size_t i = 0;
+    double settled = 0;
+    double pushes = 0;
+    double max_open_list = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        planner.AStarSearch();
+        settled += planner.Stats().settled_nodes;
+        pushes += planner.Stats().heap_pushes;
+        max_open_list += planner.Stats().max_open_list;
+        benchmark::DoNotOptimize(planner.GetDistance());
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+    state.counters["pushes"] = benchmark::Counter(pushes, benchmark::Counter::kAvgIterations);
+    state.counters["max_open_list"] = benchmark::Counter(max_open_list, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_AStarSearch, Random, bench::RandomQueries(64));
+BENCHMARK_CAPTURE(BM_AStarSearch, Long, bench::LongQueries(64));
@@ -0,0 +1,57 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "../src/route_planner.h"
+
+// Compares the settled nodes and latency of forward-only and bidirectional A* on long routes,
+// for shortest and fastest routes.
+template <typename Planner, void (Planner::*Search)()>
+static void BM_LongRoutes(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    const auto queries = bench::LongQueries(64);
+    Planner planner{model, 0, 0, 0, 0};
+
+    std::size_t i = 0;
+    double settled = 0;
+    for (auto _ : state) {
+        // Snapping is a linear scan, keep it out of the search timing.
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        (planner.*Search)();
+        settled += planner.SettledNodes();
+        benchmark::DoNotOptimize(planner.GetDistance());
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_TEMPLATE(BM_LongRoutes, RoutePlanner, &RoutePlanner::GraphAStarSearch)->Name("LongRoutes/GraphAStar");
+BENCHMARK_TEMPLATE(BM_LongRoutes, RoutePlanner, &RoutePlanner::BidirectionalAStarSearch)->Name("LongRoutes/BidirectionalAStar");
+BENCHMARK_TEMPLATE(BM_LongRoutes, FastestRoutePlanner, &FastestRoutePlanner::GraphAStarSearch)
+    ->Name("LongRoutes/GraphAStarFastest");
+BENCHMARK_TEMPLATE(BM_LongRoutes, FastestRoutePlanner, &FastestRoutePlanner::BidirectionalAStarSearch)
+    ->Name("LongRoutes/BidirectionalAStarFastest");
+
+// Optimal route plus up to two alternatives from one bidirectional search, to compare with the
+// single-route searches above.
+static void BM_AlternativeRoutes(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    const auto queries = bench::LongQueries(64);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+
+    std::size_t i = 0;
+    double settled = 0;
+    double routes = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        routes += planner.AlternativeRoutes(2).size();
+        settled += planner.SettledNodes();
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+    state.counters["routes"] = benchmark::Counter(routes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_AlternativeRoutes)->Name("LongRoutes/AlternativeRoutes");
@@ -0,0 +1,88 @@
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <array>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+#include "../src/route_model.h"
+
+namespace bench {
+
+// Start and end point of a query, in percent of the map like the interactive prompt.
+using Query = std::array<float, 4>;
+
+inline std::vector<std::byte> ReadOSMData(const std::string &path) {
+    std::ifstream is{path, std::ios::binary | std::ios::ate};
+    if (!is) {
+        return {};
+    }
+    auto size = is.tellg();
+    std::vector<std::byte> contents(size);
+    is.seekg(0);
+    is.read((char*)contents.data(), size);
+    return contents;
+}
+
+// Map that every benchmark in the binary runs on: the file named by the OSM_BENCH_MAP environment
+// variable, such as a city written by osm_generator, or else the bundled map.
+inline std::string MapFile() {
+    const char *path = std::getenv("OSM_BENCH_MAP");
+    return path ? path : "../map.osm";
+}
+
+// The model is loaded once and shared by every benchmark in the binary.
+inline RouteModel &SharedModel() {
+    static std::unique_ptr<RouteModel> model = std::make_unique<RouteModel>(ReadOSMData(MapFile()));
+    return *model;
+}
+
+// Random queries between opposite corners of the map, so every route crosses most of it.
+inline std::vector<Query> LongQueries(int count, unsigned int seed = 42) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float> near{0.0f, 25.0f};
+    std::uniform_real_distribution<float> far{75.0f, 100.0f};
+    std::vector<Query> queries;
+    for (int i = 0; i < count; ++i) {
+        Query query{near(rng), near(rng), far(rng), far(rng)};
+        if (i % 2) {
+            std::swap(query[1], query[3]);
+        }
+        queries.push_back(query);
+    }
+    return queries;
+}
+
+// Uniformly random queries anywhere on the map, short and long alike.
+inline std::vector<Query> RandomQueries(int count, unsigned int seed = 7) {
+    std::mt19937 rng{seed};
+    std::uniform_real_distribution<float> percent{0.0f, 100.0f};
+    std::vector<Query> queries;
+    for (int i = 0; i < count; ++i) {
+        queries.push_back({percent(rng), percent(rng), percent(rng), percent(rng)});
+    }
+    return queries;
+}
+
+// Drops what the code under test prints to std::cout while it is alive, such as the messages
+// of AStarSearch(), so they neither slow down nor mix with the benchmark output.
+class SilenceStdout {
+  public:
+    SilenceStdout() : m_Buffer(std::cout.rdbuf(nullptr)) {}
+    ~SilenceStdout() {
+        std::cout.rdbuf(m_Buffer);
+        std::cout.clear();
+    }
+
+  private:
+    std::streambuf *m_Buffer;
+};
+
+}  // namespace bench
+
+#endif
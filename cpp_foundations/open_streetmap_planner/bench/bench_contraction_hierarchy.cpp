@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "../src/route_planner.h"
+
+// Offline cost: node ordering and shortcut creation for the whole map.
+static void BM_ContractionHierarchyBuild(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    int shortcuts = 0;
+    for (auto _ : state) {
+        ContractionHierarchy hierarchy{model.Graph()};
+        shortcuts = hierarchy.ShortcutCount();
+    }
+    state.counters["shortcuts"] = shortcuts;
+    state.counters["nodes"] = model.Graph().NodeCount();
+}
+BENCHMARK(BM_ContractionHierarchyBuild)->Unit(benchmark::kMillisecond);
+
+// Query latency on the same long routes as the A* benchmarks, including path unpacking.
+static void BM_ContractionHierarchyQuery(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    static const ContractionHierarchy hierarchy{model.Graph()};
+    const auto queries = bench::LongQueries(64);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+
+    std::size_t i = 0;
+    double settled = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        planner.ContractionHierarchySearch(hierarchy);
+        settled += planner.SettledNodes();
+        benchmark::DoNotOptimize(planner.GetDistance());
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_ContractionHierarchyQuery)->Name("LongRoutes/ContractionHierarchy");
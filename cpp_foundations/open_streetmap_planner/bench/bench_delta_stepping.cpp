@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "bench_common.h"
+#include "../src/delta_stepping.h"
+
+// Random road nodes as sources, the same for every configuration.
+static std::vector<int> Sources(const RouteModel &model, int count) {
+    const auto &edges = model.Graph().Forward();
+    std::vector<int> road_nodes;
+    for (int v = 0; v < model.Graph().NodeCount(); ++v) {
+        if (edges.Begin(v) != edges.End(v)) {
+            road_nodes.push_back(v);
+        }
+    }
+    std::mt19937 rng{5};
+    std::uniform_int_distribution<std::size_t> pick{0, road_nodes.size() - 1};
+    std::vector<int> sources(count);
+    for (int &source : sources) {
+        source = road_nodes[pick(rng)];
+    }
+    return sources;
+}
+
+// Sequential baseline: one Dijkstra pass per source.
+static void BM_OneToAllDijkstra(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    auto sources = Sources(model, 64);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        auto tree = model.ShortestPaths(sources[next++ % sources.size()]);
+        benchmark::DoNotOptimize(tree.Nodes().data());
+    }
+}
+BENCHMARK(BM_OneToAllDijkstra)->Unit(benchmark::kMicrosecond);
+
+// Scaling by core count (first argument) for a few bucket widths in meters (second argument).
+static void BM_DeltaStepping(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    DeltaStepping delta_stepping{model.Graph(), static_cast<float>(state.range(1)), static_cast<int>(state.range(0))};
+    auto sources = Sources(model, 64);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const auto &distances = delta_stepping.Run(sources[next++ % sources.size()]);
+        benchmark::DoNotOptimize(distances.data());
+    }
+}
+static void ThreadsAndDeltas(benchmark::internal::Benchmark *bench) {
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int threads = 1; threads <= cores; threads *= 2) {
+        for (int delta : {10, 50, 200}) {
+            bench->Args({threads, delta});
+        }
+    }
+    bench->ArgNames({"threads", "delta"});
+}
+BENCHMARK(BM_DeltaStepping)->Apply(ThreadsAndDeltas)->Unit(benchmark::kMicrosecond)->UseRealTime();
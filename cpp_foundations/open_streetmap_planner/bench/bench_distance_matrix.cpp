@@ -0,0 +1,31 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "bench_common.h"
+#include "../src/distance_matrix.h"
+
+// Square tables between random points, snapped once outside the timed loop.
+static void BM_DistanceMatrix(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    static const ContractionHierarchy hierarchy{model.Graph()};
+    DistanceMatrix matrix{model, hierarchy};
+    const int size = static_cast<int>(state.range(0));
+
+    std::mt19937 rng{11};
+    std::uniform_real_distribution<float> percent{0.0f, 100.0f};
+    std::vector<DistanceMatrix::Point> points;
+    for (int i = 0; i < 2 * size; ++i) {
+        points.push_back({percent(rng), percent(rng)});
+    }
+    auto nodes = matrix.Snap(points);
+    std::vector<int> sources(nodes.begin(), nodes.begin() + size);
+    std::vector<int> targets(nodes.begin() + size, nodes.end());
+
+    float checksum = 0.0f;
+    for (auto _ : state) {
+        matrix.Stream(sources, targets, [&](int, const float *row) { checksum += row[0]; });
+    }
+    benchmark::DoNotOptimize(checksum);
+    state.counters["entries_per_second"] =
+        benchmark::Counter(static_cast<double>(size) * size, benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(BM_DistanceMatrix)->Arg(100)->Arg(1000)->Unit(benchmark::kMillisecond)->UseRealTime();
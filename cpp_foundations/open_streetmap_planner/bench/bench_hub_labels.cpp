@@ -0,0 +1,61 @@
+#include <benchmark/benchmark.h>
+#include <random>
+#include "bench_common.h"
+#include "../src/hub_labels.h"
+
+static const ContractionHierarchy &SharedHierarchy() {
+    static const ContractionHierarchy hierarchy{bench::SharedModel().Graph()};
+    return hierarchy;
+}
+
+// Random pairs of road nodes, so most queries have a route.
+static std::vector<std::pair<int, int>> RandomRoadPairs(const RouteGraph &graph, int count) {
+    std::vector<int> road_nodes;
+    for (int v = 0; v < graph.NodeCount(); ++v) {
+        if (graph.Forward().End(v) > graph.Forward().Begin(v)) {
+            road_nodes.push_back(v);
+        }
+    }
+    std::mt19937 rng{7};
+    std::vector<std::pair<int, int>> pairs;
+    for (int i = 0; i < count; ++i) {
+        pairs.emplace_back(road_nodes[rng() % road_nodes.size()], road_nodes[rng() % road_nodes.size()]);
+    }
+    return pairs;
+}
+
+static void BM_HubLabelsBuild(benchmark::State &state) {
+    const ContractionHierarchy &hierarchy = SharedHierarchy();
+    for (auto _ : state) {
+        HubLabels labels{hierarchy};
+        state.counters["bytes_per_node"] = static_cast<double>(labels.MemoryBytes()) / labels.NodeCount();
+        state.counters["avg_label_size"] = labels.AverageLabelSize();
+    }
+}
+BENCHMARK(BM_HubLabelsBuild)->Unit(benchmark::kMillisecond);
+
+// Distance-only queries: a merge join of two labels against a full hierarchy search.
+static void BM_HubLabelsDistance(benchmark::State &state) {
+    static const HubLabels labels{SharedHierarchy()};
+    const auto pairs = RandomRoadPairs(bench::SharedModel().Graph(), 1024);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto &[source, target] = pairs[i++ % pairs.size()];
+        benchmark::DoNotOptimize(labels.Distance(source, target));
+    }
+    state.counters["bytes_per_node"] = static_cast<double>(labels.MemoryBytes()) / labels.NodeCount();
+}
+BENCHMARK(BM_HubLabelsDistance)->Name("Distance/HubLabels");
+
+static void BM_ContractionHierarchyDistance(benchmark::State &state) {
+    const ContractionHierarchy &hierarchy = SharedHierarchy();
+    const auto pairs = RandomRoadPairs(bench::SharedModel().Graph(), 1024);
+    SearchSpace forward{hierarchy.NodeCount()};
+    SearchSpace backward{hierarchy.NodeCount()};
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto &[source, target] = pairs[i++ % pairs.size()];
+        benchmark::DoNotOptimize(hierarchy.Search(source, target, forward, backward).distance);
+    }
+}
+BENCHMARK(BM_ContractionHierarchyDistance)->Name("Distance/ContractionHierarchy");
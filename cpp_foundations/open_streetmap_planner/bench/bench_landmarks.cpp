@@ -0,0 +1,46 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "../src/route_planner.h"
+
+// Load time cost of landmark selection and the parallel distance table computation.
+static void BM_LandmarksBuild(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    auto selection = static_cast<Landmarks::Selection>(state.range(0));
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        Landmarks landmarks{model.Graph(), 16, selection};
+        bytes = landmarks.TableBytes();
+    }
+    state.counters["table_bytes"] = bytes;
+}
+BENCHMARK(BM_LandmarksBuild)->Arg(static_cast<int>(Landmarks::Selection::Farthest))
+    ->Arg(static_cast<int>(Landmarks::Selection::Avoid))->Unit(benchmark::kMillisecond);
+
+// Forward A* with the ALT heuristic on the same long routes as the plain A* benchmarks.
+static void BM_LongRoutesALT(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    static const Landmarks landmarks{model.Graph()};
+    const auto queries = bench::LongQueries(64);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+    planner.SetLandmarks(&landmarks);
+
+    std::size_t i = 0;
+    double settled = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        if (state.range(0)) {
+            planner.BidirectionalAStarSearch();
+        } else {
+            planner.GraphAStarSearch();
+        }
+        settled += planner.SettledNodes();
+        benchmark::DoNotOptimize(planner.GetDistance());
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_LongRoutesALT)->Name("LongRoutes/GraphAStarALT")->Arg(0);
+BENCHMARK(BM_LongRoutesALT)->Name("LongRoutes/BidirectionalAStarALT")->Arg(1);
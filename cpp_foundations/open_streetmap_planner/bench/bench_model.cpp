@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+#include "pugixml.hpp"
+#include "bench_common.h"
+#include "../src/route_model.h"
+#include "../src/turn_table.h"
+
+// Model loading, phase by phase. Model construction includes the XML parse and RouteModel
+// construction includes Model, so the cost of a phase is the difference to the one before.
+
+static void BM_ReadFile(benchmark::State &state) {
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        bytes = bench::ReadOSMData(bench::MapFile()).size();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes) * state.iterations());
+}
+BENCHMARK(BM_ReadFile)->Unit(benchmark::kMillisecond);
+
+static void BM_ParseXml(benchmark::State &state) {
+    const auto xml = bench::ReadOSMData(bench::MapFile());
+    for (auto _ : state) {
+        pugi::xml_document doc;
+        benchmark::DoNotOptimize(doc.load_buffer(xml.data(), xml.size()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(xml.size()) * state.iterations());
+}
+BENCHMARK(BM_ParseXml)->Unit(benchmark::kMillisecond);
+
+// Parse, extraction of nodes, ways, roads and areas, and coordinate adjustment.
+static void BM_Model(benchmark::State &state) {
+    const auto xml = bench::ReadOSMData(bench::MapFile());
+    std::size_t nodes = 0;
+    for (auto _ : state) {
+        Model model{xml};
+        nodes = model.Nodes().size();
+    }
+    state.counters["nodes"] = nodes;
+}
+BENCHMARK(BM_Model)->Unit(benchmark::kMillisecond);
+
+// Model plus the search nodes and the node to road index of the legacy A*.
+static void BM_RouteModel(benchmark::State &state) {
+    const auto xml = bench::ReadOSMData(bench::MapFile());
+    for (auto _ : state) {
+        RouteModel model{xml};
+        benchmark::DoNotOptimize(model.SNodes().data());
+    }
+}
+BENCHMARK(BM_RouteModel)->Unit(benchmark::kMillisecond);
+
+// Road graph of a profile, built on first use of the profile.
+static void BM_RouteGraph(benchmark::State &state, RouteGraph::Profile profile) {
+    const Model &model = bench::SharedModel();
+    int edges = 0;
+    for (auto _ : state) {
+        RouteGraph graph{model, profile};
+        edges = graph.EdgeCount();
+    }
+    state.counters["edges"] = edges;
+}
+BENCHMARK_CAPTURE(BM_RouteGraph, Car, RouteGraph::Profile::Car)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RouteGraph, Foot, RouteGraph::Profile::Foot)->Unit(benchmark::kMillisecond);
+
+static void BM_TurnTable(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    for (auto _ : state) {
+        TurnTable turns{model, model.Graph()};
+        benchmark::DoNotOptimize(turns.BannedTurns());
+    }
+}
+BENCHMARK(BM_TurnTable)->Unit(benchmark::kMicrosecond);
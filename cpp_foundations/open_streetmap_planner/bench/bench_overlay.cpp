@@ -0,0 +1,49 @@
+#include <benchmark/benchmark.h>
+#include "bench_common.h"
+#include "../src/route_planner.h"
+
+// Metric independent preprocessing: partition and overlay boundaries.
+static void BM_OverlayPartition(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    for (auto _ : state) {
+        Partition partition{model, model.Graph()};
+        benchmark::DoNotOptimize(partition.CellCount(0));
+    }
+}
+BENCHMARK(BM_OverlayPartition)->Unit(benchmark::kMillisecond);
+
+// Reacting to new weights: alternate between lengths and travel times on a fixed partition.
+static void BM_OverlayCustomize(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    static const Partition partition{model, model.Graph()};
+    Overlay overlay{model.Graph(), partition, static_cast<int>(state.range(0))};
+    const std::vector<std::vector<float>> metrics{model.Graph().Forward().weight, model.Graph().TravelTimes()};
+    std::size_t i = 0;
+    for (auto _ : state) {
+        overlay.Customize(metrics[i++ % metrics.size()]);
+    }
+}
+BENCHMARK(BM_OverlayCustomize)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_OverlayQuery(benchmark::State &state) {
+    RouteModel &model = bench::SharedModel();
+    static const Partition partition{model, model.Graph()};
+    static const Overlay overlay{model.Graph(), partition};
+    const auto queries = bench::LongQueries(64);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+
+    std::size_t i = 0;
+    double settled = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        planner.OverlaySearch(overlay);
+        settled += planner.SettledNodes();
+        benchmark::DoNotOptimize(planner.GetDistance());
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OverlayQuery)->Name("LongRoutes/Overlay");
@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+#include <map>
+#include <sstream>
+#include "bench_common.h"
+#include "../src/osm_generator.h"
+#include "../src/route_planner.h"
+
+// Scaling of loading, snapping and the legacy A* with the map size, on random planar cities of
+// 1k to 64k nodes. The fitted complexity shows superlinear behavior that the bundled map is
+// too small to reveal.
+
+static std::vector<std::byte> SyntheticOSMData(std::int64_t nodes) {
+    SyntheticCity city;
+    city.layout = SyntheticCity::Layout::RandomPlanar;
+    city.target_nodes = nodes;
+    std::ostringstream os;
+    WriteSyntheticCity(os, city);
+    const std::string xml = os.str();
+    const auto *bytes = reinterpret_cast<const std::byte *>(xml.data());
+    return {bytes, bytes + xml.size()};
+}
+
+// Cities are generated and loaded once per size and shared by the benchmarks.
+static RouteModel &SyntheticModel(std::int64_t nodes) {
+    static std::map<std::int64_t, std::unique_ptr<RouteModel>> models;
+    auto &model = models[nodes];
+    if (!model) {
+        model = std::make_unique<RouteModel>(SyntheticOSMData(nodes));
+    }
+    return *model;
+}
+
+static void BM_SyntheticModelLoad(benchmark::State &state) {
+    const auto xml = SyntheticOSMData(state.range(0));
+    std::size_t nodes = 0;
+    for (auto _ : state) {
+        RouteModel model{xml};
+        nodes = model.Nodes().size();
+    }
+    state.SetComplexityN(static_cast<int64_t>(nodes));
+    state.SetBytesProcessed(static_cast<int64_t>(xml.size()) * state.iterations());
+}
+BENCHMARK(BM_SyntheticModelLoad)->RangeMultiplier(4)->Range(1 << 10, 1 << 16)->Unit(benchmark::kMillisecond)
+    ->Complexity();
+
+static void BM_SyntheticFindClosestNode(benchmark::State &state) {
+    RouteModel &model = SyntheticModel(state.range(0));
+    const auto queries = bench::RandomQueries(64);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const auto &query = queries[i++ % queries.size()];
+        benchmark::DoNotOptimize(&model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f));
+    }
+    state.SetComplexityN(static_cast<int64_t>(model.Nodes().size()));
+}
+BENCHMARK(BM_SyntheticFindClosestNode)->RangeMultiplier(4)->Range(1 << 10, 1 << 16)->Complexity();
+
+// Legacy AStarSearch() against GraphAStarSearch() on the same corner to corner routes.
+static void BM_SyntheticAStarSearch(benchmark::State &state, bool legacy) {
+    RouteModel &model = SyntheticModel(state.range(0));
+    const auto queries = bench::LongQueries(16);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+    planner.SetSnapToLargestComponent(true);
+    bench::SilenceStdout silence;
+
+    std::size_t i = 0;
+    double settled = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        const auto &query = queries[i++ % queries.size()];
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        state.ResumeTiming();
+
+        if (legacy) {
+            planner.AStarSearch();
+        } else {
+            planner.GraphAStarSearch();
+        }
+        settled += planner.SettledNodes();
+    }
+    state.counters["settled"] = benchmark::Counter(settled, benchmark::Counter::kAvgIterations);
+    state.SetComplexityN(static_cast<int64_t>(model.Nodes().size()));
+}
+BENCHMARK_CAPTURE(BM_SyntheticAStarSearch, Legacy, true)->RangeMultiplier(4)->Range(1 << 10, 1 << 16)
+    ->Unit(benchmark::kMicrosecond)->Complexity();
+BENCHMARK_CAPTURE(BM_SyntheticAStarSearch, Graph, false)->RangeMultiplier(4)->Range(1 << 10, 1 << 16)
+    ->Unit(benchmark::kMicrosecond)->Complexity();
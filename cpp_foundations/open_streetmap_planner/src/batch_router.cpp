@@ -0,0 +1,120 @@
+#include "batch_router.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace {
+
+double Percentile(std::vector<double> sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    std::size_t index = static_cast<std::size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+template <typename T>
+void WriteValue(std::ostream &os, T value) {
+    os.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+BatchRouter::BatchRouter(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count) :
+    m_Model(model), m_Hierarchy(hierarchy), m_Pool(thread_count),
+    m_Forward(m_Pool.Size(), SearchSpace{hierarchy.NodeCount()}),
+    m_Backward(m_Pool.Size(), SearchSpace{hierarchy.NodeCount()}) {}
+
+std::vector<BatchRouter::Result> BatchRouter::Run(const std::vector<Query> &queries) {
+    using Clock = std::chrono::steady_clock;
+    std::vector<Result> results(queries.size());
+    auto start = Clock::now();
+    m_Pool.ParallelFor(static_cast<int>(queries.size()), [&](int i, int worker) {
+        auto query_start = Clock::now();
+        const Query &query = queries[i];
+        int source = m_Model.FindClosestNode(query.start_x * 0.01f, query.start_y * 0.01f).Index();
+        int target = m_Model.FindClosestNode(query.end_x * 0.01f, query.end_y * 0.01f).Index();
+        auto search_start = Clock::now();
+        results[i].stats.snap_us = std::chrono::duration<double, std::micro>(search_start - query_start).count();
+        if (m_Cache) {
+            if (auto route = m_Cache->Find(source, target)) {
+                results[i].distance = route->distance;
+                results[i].path = route->path;
+                results[i].cached = true;
+            }
+        }
+        if (!results[i].cached) {
+            auto version = m_Cache ? m_Cache->Version() : 0;
+            auto search = m_Hierarchy.Search(source, target, m_Forward[worker], m_Backward[worker]);
+            results[i].distance = search.distance;
+            results[i].stats.settled_nodes = search.settled_nodes;
+            results[i].stats.search_us = std::chrono::duration<double, std::micro>(Clock::now() - search_start).count();
+            results[i].path = m_Hierarchy.UnpackPath(search, m_Forward[worker], m_Backward[worker]);
+            if (m_Cache) {
+                m_Cache->Insert(source, target, results[i].distance, results[i].path, version);
+            }
+        }
+        results[i].latency_us = std::chrono::duration<double, std::micro>(Clock::now() - query_start).count();
+    }, 4);
+
+    m_Summary = Summary{};
+    m_Summary.queries = static_cast<int>(queries.size());
+    m_Summary.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    m_Summary.queries_per_second = m_Summary.seconds > 0.0 ? m_Summary.queries / m_Summary.seconds : 0.0;
+    std::vector<double> latencies;
+    latencies.reserve(results.size());
+    for (const Result &result : results) {
+        latencies.push_back(result.latency_us);
+        m_Summary.cache_hits += result.cached;
+        m_Summary.search.Add(result.stats);
+    }
+    m_Summary.p50_us = Percentile(latencies, 0.50);
+    m_Summary.p99_us = Percentile(latencies, 0.99);
+    return results;
+}
+
+std::vector<BatchRouter::Query> BatchRouter::ReadQueries(std::istream &is) {
+    std::vector<Query> queries;
+    std::string line;
+    while (std::getline(is, line)) {
+        auto first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields{line};
+        Query query;
+        if (fields >> query.start_x >> query.start_y >> query.end_x >> query.end_y) {
+            queries.push_back(query);
+        }
+    }
+    return queries;
+}
+
+void BatchRouter::WriteCsv(std::ostream &os, const std::vector<Result> &results) {
+    os << "query,distance_m,path\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        os << i << ',' << results[i].distance << ',';
+        for (std::size_t j = 0; j < results[i].path.size(); ++j) {
+            os << (j ? " " : "") << results[i].path[j];
+        }
+        os << '\n';
+    }
+}
+
+void BatchRouter::WriteBinary(std::ostream &os, const std::vector<Result> &results) {
+    os.write("OSMR", 4);
+    WriteValue<std::uint32_t>(os, results.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        WriteValue<std::uint32_t>(os, i);
+        WriteValue<float>(os, results[i].distance);
+        WriteValue<std::uint32_t>(os, results[i].path.size());
+        for (int node : results[i].path) {
+            WriteValue<std::int32_t>(os, node);
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef BATCH_ROUTER_H
+#define BATCH_ROUTER_H
+
+#include <iostream>
+#include <vector>
+#include "contraction_hierarchy.h"
+#include "route_cache.h"
+#include "route_model.h"
+#include "search_stats.h"
+#include "thread_pool.h"
+
+// Headless routing of many queries at once. Every worker of a thread pool owns its own search
+// spaces and answers queries with the shared, read-only model and contraction hierarchy.
+class BatchRouter {
+  public:
+    // Start and end point in percent of the map, like the RoutePlanner endpoints.
+    struct Query {
+        float start_x;
+        float start_y;
+        float end_x;
+        float end_y;
+    };
+
+    struct Result {
+        float distance = 0.0f;  // Meters; infinity if there is no route.
+        std::vector<int> path;  // Node indices from start to end.
+        double latency_us = 0.0;
+        bool cached = false;
+        // Snapping and search work of the query. The search fields stay zero for cache hits.
+        SearchStats stats;
+    };
+
+    struct Summary {
+        int queries = 0;
+        double seconds = 0.0;
+        double queries_per_second = 0.0;
+        double p50_us = 0.0;
+        double p99_us = 0.0;
+        int cache_hits = 0;
+        SearchStatsHistogram search;  // Distribution of the per-query stats.
+    };
+
+    BatchRouter(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count = 0);
+
+    // Look routes up in cache before searching and store new ones there. The cache must be
+    // invalidated whenever the model is reloaded. nullptr disables caching.
+    void SetCache(RouteCache *cache) { m_Cache = cache; }
+
+    std::vector<Result> Run(const std::vector<Query> &queries);
+    // Throughput, latency percentiles and search stats of the last Run().
+    const Summary &LastSummary() const { return m_Summary; }
+
+    // One query per line as "start_x start_y end_x end_y", separated by spaces or commas.
+    // Blank lines and lines starting with '#' are skipped.
+    static std::vector<Query> ReadQueries(std::istream &is);
+    // CSV with a header row: query index, distance in meters and the path as node indices.
+    static void WriteCsv(std::ostream &os, const std::vector<Result> &results);
+    // Records of (uint32 query, float distance, uint32 length, int32 nodes[length]) in native
+    // byte order, after an "OSMR" magic and the uint32 record count.
+    static void WriteBinary(std::ostream &os, const std::vector<Result> &results);
+
+  private:
+    RouteModel &m_Model;
+    const ContractionHierarchy &m_Hierarchy;
+    RouteCache *m_Cache = nullptr;
+    ThreadPool m_Pool;
+    std::vector<SearchSpace> m_Forward;
+    std::vector<SearchSpace> m_Backward;
+    Summary m_Summary;
+};
+
+#endif
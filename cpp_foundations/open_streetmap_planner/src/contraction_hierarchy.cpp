@@ -0,0 +1,492 @@
+#include "contraction_hierarchy.h"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+namespace {
+
+using Edge = ContractionHierarchy::Edge;
+using MinQueue = std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>,
+                                     std::greater<std::pair<float, int>>>;
+
+constexpr std::uint32_t kFileMagic = 0x4843534f;  // "OSCH"
+// Version 2: built on the directed road graph.
+constexpr std::int32_t kFileVersion = 2;
+// Witness searches give up after this many nodes. Giving up early only adds extra shortcuts.
+constexpr int kWitnessSettleLimit = 500;
+
+// Working state of the node ordering and contraction.
+class Contractor {
+  public:
+    Contractor(const RouteGraph &graph) :
+        out_edges(graph.NodeCount()), in_edges(graph.NodeCount()), contracted(graph.NodeCount(), false),
+        contracted_neighbors(graph.NodeCount(), 0), level(graph.NodeCount(), 0), witness(graph.NodeCount()) {
+        const auto &forward = graph.Forward();
+        const auto &backward = graph.Backward();
+        for (int v = 0; v < graph.NodeCount(); ++v) {
+            for (int e = forward.Begin(v); e < forward.End(v); ++e) {
+                out_edges[v].push_back({forward.head[e], forward.weight[e], -1});
+            }
+            for (int e = backward.Begin(v); e < backward.End(v); ++e) {
+                in_edges[v].push_back({backward.head[e], backward.weight[e], -1});
+            }
+        }
+    }
+
+    // Contract every node and return the rank of each one.
+    std::vector<int> Run() {
+        const int node_count = static_cast<int>(out_edges.size());
+        MinQueue queue;
+        for (int v = 0; v < node_count; ++v) {
+            queue.emplace(Priority(v), v);
+        }
+
+        std::vector<int> rank(node_count, 0);
+        int next_rank = 0;
+        while (!queue.empty()) {
+            int v = queue.top().second;
+            queue.pop();
+            if (contracted[v]) {
+                continue;
+            }
+            // Lazy update: the stored priority may be outdated by earlier contractions.
+            float priority = Priority(v);
+            if (!queue.empty() && priority > queue.top().first) {
+                queue.emplace(priority, v);
+                continue;
+            }
+            Contract(v, true);
+            contracted[v] = true;
+            rank[v] = next_rank++;
+            for (const auto *edges : {&out_edges[v], &in_edges[v]}) {
+                for (const Edge &edge : *edges) {
+                    contracted_neighbors[edge.head]++;
+                    level[edge.head] = std::max(level[edge.head], level[v] + 1);
+                }
+            }
+        }
+        return rank;
+    }
+
+    std::vector<std::vector<Edge>> out_edges;
+    // Incoming edges, with the tail of the edge stored in Edge::head.
+    std::vector<std::vector<Edge>> in_edges;
+    int shortcut_count = 0;
+
+  private:
+    float Priority(int v) {
+        int removed = 0;
+        for (const auto *edges : {&out_edges[v], &in_edges[v]}) {
+            for (const Edge &edge : *edges) {
+                removed += contracted[edge.head] ? 0 : 1;
+            }
+        }
+        int edge_difference = Contract(v, false) - removed;
+        return 2.0f * edge_difference + contracted_neighbors[v] + level[v];
+    }
+
+    // Count the shortcuts needed to bypass v, and add them when add is set.
+    int Contract(int v, bool add) {
+        float max_out = 0.0f;
+        for (const Edge &out : out_edges[v]) {
+            if (!contracted[out.head]) {
+                max_out = std::max(max_out, out.weight);
+            }
+        }
+
+        int shortcuts = 0;
+        for (const Edge &in : in_edges[v]) {
+            int u = in.head;
+            if (contracted[u]) {
+                continue;
+            }
+            WitnessSearch(u, v, in.weight + max_out);
+            for (const Edge &out : out_edges[v]) {
+                int w = out.head;
+                if (contracted[w] || w == u) {
+                    continue;
+                }
+                float via = in.weight + out.weight;
+                if (witness.Distance(w) <= via) {
+                    continue;
+                }
+                shortcuts++;
+                if (add) {
+                    AddShortcut(u, w, via, v);
+                }
+            }
+        }
+        return shortcuts;
+    }
+
+    // Bounded Dijkstra from source over the remaining graph, avoiding the node being contracted.
+    void WitnessSearch(int source, int skipped, float max_distance) {
+        witness.Clear();
+        witness.Reach(source, 0.0f, -1);
+        MinQueue queue;
+        queue.emplace(0.0f, source);
+        int settled = 0;
+        while (!queue.empty() && settled < kWitnessSettleLimit) {
+            auto [distance, u] = queue.top();
+            queue.pop();
+            if (witness.Settled(u)) {
+                continue;
+            }
+            if (distance > max_distance) {
+                break;
+            }
+            witness.Settle(u);
+            settled++;
+            for (const Edge &edge : out_edges[u]) {
+                if (contracted[edge.head] || edge.head == skipped) {
+                    continue;
+                }
+                float candidate = distance + edge.weight;
+                if (candidate < witness.Distance(edge.head)) {
+                    witness.Reach(edge.head, candidate, u);
+                    queue.emplace(candidate, edge.head);
+                }
+            }
+        }
+    }
+
+    void AddShortcut(int tail, int head, float weight, int middle) {
+        auto existing = std::find_if(out_edges[tail].begin(), out_edges[tail].end(),
+                                     [&](const Edge &edge) { return edge.head == head; });
+        if (existing == out_edges[tail].end()) {
+            out_edges[tail].push_back({head, weight, middle});
+            in_edges[head].push_back({tail, weight, middle});
+            shortcut_count++;
+            return;
+        }
+        if (existing->weight <= weight) {
+            return;
+        }
+        *existing = {head, weight, middle};
+        for (Edge &edge : in_edges[head]) {
+            if (edge.head == tail) {
+                edge = {tail, weight, middle};
+            }
+        }
+    }
+
+    std::vector<bool> contracted;
+    std::vector<int> contracted_neighbors;
+    std::vector<int> level;
+    SearchSpace witness;
+};
+
+template <typename T>
+void WriteVector(std::ofstream &os, const std::vector<T> &values) {
+    std::int64_t size = values.size();
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    os.write(reinterpret_cast<const char*>(values.data()), sizeof(T) * values.size());
+}
+
+template <typename T>
+bool ReadVector(std::ifstream &is, std::vector<T> &values) {
+    std::int64_t size = 0;
+    if (!is.read(reinterpret_cast<char*>(&size), sizeof(size)) || size < 0) {
+        return false;
+    }
+    // A damaged size must not allocate more than the rest of the file can fill.
+    const std::streampos position = is.tellg();
+    is.seekg(0, std::ios::end);
+    const std::streamoff remaining = is.tellg() - position;
+    is.seekg(position);
+    if (!is || size > remaining / static_cast<std::streamoff>(sizeof(T))) {
+        return false;
+    }
+    values.resize(size);
+    return static_cast<bool>(is.read(reinterpret_cast<char*>(values.data()), sizeof(T) * size));
+}
+
+// Check a search graph read from a file: offsets that start at zero and never decrease, and
+// edges whose other end ranks above v and whose shortcut middle ranks below both ends, so that
+// searches stay in bounds and unpacking a shortcut always ends.
+bool ValidSearchGraph(const std::vector<int> &rank, const std::vector<int> &first, const std::vector<Edge> &edges) {
+    const int node_count = static_cast<int>(rank.size());
+    if (first.front() != 0) {
+        return false;
+    }
+    for (int v = 0; v < node_count; ++v) {
+        if (first[v + 1] < first[v]) {
+            return false;
+        }
+        for (int e = first[v]; e < first[v + 1]; ++e) {
+            const Edge &edge = edges[e];
+            if (edge.head < 0 || edge.head >= node_count || rank[edge.head] <= rank[v]) {
+                return false;
+            }
+            if (edge.middle != -1 && (edge.middle < 0 || edge.middle >= node_count || rank[edge.middle] >= rank[v])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+ContractionHierarchy::ContractionHierarchy(const RouteGraph &graph) : m_GraphEdgeCount(graph.EdgeCount()) {
+    Contractor contractor{graph};
+    m_Rank = contractor.Run();
+    m_ShortcutCount = contractor.shortcut_count;
+    BuildSearchGraphs(contractor.out_edges);
+}
+
+void ContractionHierarchy::BuildSearchGraphs(const std::vector<std::vector<Edge>> &out_edges) {
+    const int node_count = static_cast<int>(m_Rank.size());
+    m_UpFirst.assign(node_count + 1, 0);
+    m_DownFirst.assign(node_count + 1, 0);
+    for (int v = 0; v < node_count; ++v) {
+        for (const Edge &edge : out_edges[v]) {
+            if (m_Rank[edge.head] > m_Rank[v]) {
+                m_UpFirst[v + 1]++;
+            } else {
+                m_DownFirst[edge.head + 1]++;
+            }
+        }
+    }
+    for (int v = 0; v < node_count; ++v) {
+        m_UpFirst[v + 1] += m_UpFirst[v];
+        m_DownFirst[v + 1] += m_DownFirst[v];
+    }
+
+    m_Up.resize(m_UpFirst[node_count]);
+    m_Down.resize(m_DownFirst[node_count]);
+    std::vector<int> up_fill(m_UpFirst.begin(), m_UpFirst.end() - 1);
+    std::vector<int> down_fill(m_DownFirst.begin(), m_DownFirst.end() - 1);
+    for (int v = 0; v < node_count; ++v) {
+        for (const Edge &edge : out_edges[v]) {
+            if (m_Rank[edge.head] > m_Rank[v]) {
+                m_Up[up_fill[v]++] = edge;
+            } else {
+                m_Down[down_fill[edge.head]++] = {v, edge.weight, edge.middle};
+            }
+        }
+    }
+}
+
+std::optional<ContractionHierarchy> ContractionHierarchy::Load(const std::string &path, const RouteGraph &graph) {
+    std::ifstream is{path, std::ios::binary};
+    if (!is) {
+        return std::nullopt;
+    }
+    std::uint32_t magic = 0;
+    std::int32_t version = 0;
+    std::int32_t node_count = 0;
+    ContractionHierarchy hierarchy;
+    is.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    is.read(reinterpret_cast<char*>(&version), sizeof(version));
+    is.read(reinterpret_cast<char*>(&node_count), sizeof(node_count));
+    is.read(reinterpret_cast<char*>(&hierarchy.m_GraphEdgeCount), sizeof(hierarchy.m_GraphEdgeCount));
+    is.read(reinterpret_cast<char*>(&hierarchy.m_ShortcutCount), sizeof(hierarchy.m_ShortcutCount));
+    if (!is || magic != kFileMagic || version != kFileVersion || node_count != graph.NodeCount() ||
+        hierarchy.m_GraphEdgeCount != graph.EdgeCount()) {
+        return std::nullopt;
+    }
+    if (!ReadVector(is, hierarchy.m_Rank) || !ReadVector(is, hierarchy.m_UpFirst) || !ReadVector(is, hierarchy.m_Up) ||
+        !ReadVector(is, hierarchy.m_DownFirst) || !ReadVector(is, hierarchy.m_Down)) {
+        return std::nullopt;
+    }
+    if (hierarchy.m_Rank.size() != static_cast<std::size_t>(node_count) ||
+        hierarchy.m_UpFirst.size() != hierarchy.m_Rank.size() + 1 ||
+        hierarchy.m_DownFirst.size() != hierarchy.m_Rank.size() + 1 ||
+        hierarchy.m_UpFirst.back() != static_cast<int>(hierarchy.m_Up.size()) ||
+        hierarchy.m_DownFirst.back() != static_cast<int>(hierarchy.m_Down.size())) {
+        return std::nullopt;
+    }
+    // Ranks index per rank arrays, e.g. in HubLabels, so they must be a permutation of the nodes.
+    std::vector<bool> ranked(node_count, false);
+    for (int rank : hierarchy.m_Rank) {
+        if (rank < 0 || rank >= node_count || ranked[rank]) {
+            return std::nullopt;
+        }
+        ranked[rank] = true;
+    }
+    if (!ValidSearchGraph(hierarchy.m_Rank, hierarchy.m_UpFirst, hierarchy.m_Up) ||
+        !ValidSearchGraph(hierarchy.m_Rank, hierarchy.m_DownFirst, hierarchy.m_Down)) {
+        return std::nullopt;
+    }
+    return hierarchy;
+}
+
+bool ContractionHierarchy::Save(const std::string &path) const {
+    std::ofstream os{path, std::ios::binary};
+    if (!os) {
+        return false;
+    }
+    std::int32_t node_count = NodeCount();
+    os.write(reinterpret_cast<const char*>(&kFileMagic), sizeof(kFileMagic));
+    os.write(reinterpret_cast<const char*>(&kFileVersion), sizeof(kFileVersion));
+    os.write(reinterpret_cast<const char*>(&node_count), sizeof(node_count));
+    os.write(reinterpret_cast<const char*>(&m_GraphEdgeCount), sizeof(m_GraphEdgeCount));
+    os.write(reinterpret_cast<const char*>(&m_ShortcutCount), sizeof(m_ShortcutCount));
+    WriteVector(os, m_Rank);
+    WriteVector(os, m_UpFirst);
+    WriteVector(os, m_Up);
+    WriteVector(os, m_DownFirst);
+    WriteVector(os, m_Down);
+    return static_cast<bool>(os);
+}
+
+ContractionHierarchy::SearchResult ContractionHierarchy::Search(int source, int target, SearchSpace &forward,
+                                                                SearchSpace &backward) const {
+    SearchResult result;
+    forward.Clear();
+    backward.Clear();
+    MinQueue forward_queue;
+    MinQueue backward_queue;
+    forward.Reach(source, 0.0f, -1);
+    forward_queue.emplace(0.0f, source);
+    backward.Reach(target, 0.0f, -1);
+    backward_queue.emplace(0.0f, target);
+
+    bool forward_turn = true;
+    while (!forward_queue.empty() || !backward_queue.empty()) {
+        // A direction is finished once its smallest key can no longer improve the result.
+        for (MinQueue *queue : {&forward_queue, &backward_queue}) {
+            if (!queue->empty() && queue->top().first >= result.distance) {
+                *queue = MinQueue{};
+            }
+        }
+        if (forward_queue.empty() && backward_queue.empty()) {
+            break;
+        }
+        // Alternate between the directions while both have work left.
+        bool is_forward = backward_queue.empty() || (!forward_queue.empty() && forward_turn);
+        forward_turn = !forward_turn;
+
+        MinQueue &queue = is_forward ? forward_queue : backward_queue;
+        SearchSpace &space = is_forward ? forward : backward;
+        const SearchSpace &other = is_forward ? backward : forward;
+        const auto &first = is_forward ? m_UpFirst : m_DownFirst;
+        const auto &edges = is_forward ? m_Up : m_Down;
+        const auto &opposite_first = is_forward ? m_DownFirst : m_UpFirst;
+        const auto &opposite_edges = is_forward ? m_Down : m_Up;
+
+        auto [distance, u] = queue.top();
+        queue.pop();
+        if (space.Settled(u)) {
+            continue;
+        }
+        space.Settle(u);
+        result.settled_nodes++;
+        if (other.Reached(u) && distance + other.Distance(u) < result.distance) {
+            result.distance = distance + other.Distance(u);
+            result.meeting_node = u;
+        }
+
+        // Stall on demand: if a higher node already offers a shorter way to u, the label of u
+        // is not a shortest path distance and nothing above it needs to be explored from here.
+        bool stalled = false;
+        for (int e = opposite_first[u]; e < opposite_first[u + 1] && !stalled; ++e) {
+            stalled = space.Distance(opposite_edges[e].head) + opposite_edges[e].weight < distance;
+        }
+        if (stalled) {
+            continue;
+        }
+        for (int e = first[u]; e < first[u + 1]; ++e) {
+            int v = edges[e].head;
+            float candidate = distance + edges[e].weight;
+            if (candidate < space.Distance(v)) {
+                space.Reach(v, candidate, u);
+                queue.emplace(candidate, v);
+            }
+        }
+    }
+    return result;
+}
+
+void ContractionHierarchy::UpwardSearch(int v, bool forward, SearchSpace &space,
+                                        std::vector<std::pair<int, float>> &settled) const {
+    const auto &first = forward ? m_UpFirst : m_DownFirst;
+    const auto &edges = forward ? m_Up : m_Down;
+    const auto &opposite_first = forward ? m_DownFirst : m_UpFirst;
+    const auto &opposite_edges = forward ? m_Down : m_Up;
+    space.Clear();
+    space.Reach(v, 0.0f, -1);
+    MinQueue queue;
+    queue.emplace(0.0f, v);
+    while (!queue.empty()) {
+        auto [distance, u] = queue.top();
+        queue.pop();
+        if (space.Settled(u)) {
+            continue;
+        }
+        space.Settle(u);
+        // Stalled nodes have no shortest distance label, so they are neither reported nor expanded.
+        bool stalled = false;
+        for (int e = opposite_first[u]; e < opposite_first[u + 1] && !stalled; ++e) {
+            stalled = space.Distance(opposite_edges[e].head) + opposite_edges[e].weight < distance;
+        }
+        if (stalled) {
+            continue;
+        }
+        settled.emplace_back(u, distance);
+        for (int e = first[u]; e < first[u + 1]; ++e) {
+            float candidate = distance + edges[e].weight;
+            if (candidate < space.Distance(edges[e].head)) {
+                space.Reach(edges[e].head, candidate, u);
+                queue.emplace(candidate, edges[e].head);
+            }
+        }
+    }
+}
+
+std::vector<int> ContractionHierarchy::UnpackPath(const SearchResult &result, const SearchSpace &forward,
+                                                  const SearchSpace &backward) const {
+    std::vector<int> path;
+    if (result.meeting_node == -1) {
+        return path;
+    }
+    std::vector<int> upward;
+    for (int v = result.meeting_node; v != -1; v = forward.Parent(v)) {
+        upward.push_back(v);
+    }
+    std::reverse(upward.begin(), upward.end());
+    path.push_back(upward.front());
+    for (std::size_t i = 1; i < upward.size(); ++i) {
+        UnpackEdge(upward[i - 1], upward[i], FindEdge(upward[i - 1], upward[i]).middle, path);
+    }
+    for (int v = result.meeting_node; backward.Parent(v) != -1; v = backward.Parent(v)) {
+        int next = backward.Parent(v);
+        UnpackEdge(v, next, FindEdge(v, next).middle, path);
+    }
+    return path;
+}
+
+// Append the nodes of the edge tail -> head, excluding tail, with every shortcut expanded.
+void ContractionHierarchy::UnpackEdge(int tail, int head, int middle, std::vector<int> &path) const {
+    if (middle == -1) {
+        path.push_back(head);
+        return;
+    }
+    UnpackEdge(tail, middle, FindEdge(tail, middle).middle, path);
+    UnpackEdge(middle, head, FindEdge(middle, head).middle, path);
+}
+
+const ContractionHierarchy::Edge &ContractionHierarchy::FindEdge(int tail, int head) const {
+    // Each edge is stored once, at its lower ranked end.
+    const Edge *begin = nullptr;
+    const Edge *end = nullptr;
+    int other = 0;
+    if (m_Rank[tail] < m_Rank[head]) {
+        begin = m_Up.data() + m_UpFirst[tail];
+        end = m_Up.data() + m_UpFirst[tail + 1];
+        other = head;
+    } else {
+        begin = m_Down.data() + m_DownFirst[head];
+        end = m_Down.data() + m_DownFirst[head + 1];
+        other = tail;
+    }
+    auto it = std::find_if(begin, end, [other](const Edge &edge) { return edge.head == other; });
+    if (it == end) {
+        throw std::logic_error("contraction hierarchy is missing an edge");
+    }
+    return *it;
+}
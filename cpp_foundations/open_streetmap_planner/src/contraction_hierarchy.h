@@ -0,0 +1,81 @@
+#ifndef CONTRACTION_HIERARCHY_H
+#define CONTRACTION_HIERARCHY_H
+
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+#include "route_graph.h"
+#include "search_space.h"
+
+// Contraction Hierarchy over a RouteGraph. Nodes are contracted one by one in order of
+// importance and shortcuts keep the distances between the remaining nodes intact. A query is
+// then a bidirectional Dijkstra that only climbs upward in the hierarchy.
+class ContractionHierarchy {
+  public:
+    struct Edge {
+        int head;
+        float weight;
+        int middle;  // Node the shortcut skips over, or -1 for an original road segment.
+    };
+
+    // Contiguous run of edges in one of the search graphs.
+    struct EdgeRange {
+        const Edge *first;
+        const Edge *last;
+        const Edge *begin() const { return first; }
+        const Edge *end() const { return last; }
+    };
+
+    // Result of a search; the path is recovered with UnpackPath().
+    struct SearchResult {
+        float distance = std::numeric_limits<float>::infinity();
+        int meeting_node = -1;
+        int settled_nodes = 0;
+    };
+
+    // Order the nodes and add shortcuts. This is the expensive offline step.
+    ContractionHierarchy(const RouteGraph &graph);
+
+    // Load a hierarchy written by Save(). Returns nothing if the file is missing, damaged or was
+    // built for a different graph.
+    static std::optional<ContractionHierarchy> Load(const std::string &path, const RouteGraph &graph);
+    bool Save(const std::string &path) const;
+
+    int NodeCount() const { return static_cast<int>(m_Rank.size()); }
+    int Rank(int v) const { return m_Rank[v]; }
+    int ShortcutCount() const { return m_ShortcutCount; }
+    // Edges from v to higher ranked nodes.
+    EdgeRange UpwardEdges(int v) const { return {m_Up.data() + m_UpFirst[v], m_Up.data() + m_UpFirst[v + 1]}; }
+    // Edges into v from higher ranked nodes, with the tail in Edge::head.
+    EdgeRange DownwardEdges(int v) const { return {m_Down.data() + m_DownFirst[v], m_Down.data() + m_DownFirst[v + 1]}; }
+
+    // Upward search from both ends. The search spaces are cleared here and keep the labels
+    // UnpackPath() needs; both must be sized for NodeCount() nodes.
+    SearchResult Search(int source, int target, SearchSpace &forward, SearchSpace &backward) const;
+    // Complete upward search from v without a target, forward or backward, for one-to-many and
+    // many-to-many algorithms. Appends every node whose label is a shortest distance.
+    void UpwardSearch(int v, bool forward, SearchSpace &space, std::vector<std::pair<int, float>> &settled) const;
+    // Node indices of the shortest path of the last Search(), with every shortcut expanded.
+    std::vector<int> UnpackPath(const SearchResult &result, const SearchSpace &forward,
+                                const SearchSpace &backward) const;
+
+  private:
+    ContractionHierarchy() = default;
+    void BuildSearchGraphs(const std::vector<std::vector<Edge>> &out_edges);
+    void UnpackEdge(int tail, int head, int middle, std::vector<int> &path) const;
+    const Edge &FindEdge(int tail, int head) const;
+
+    std::vector<int> m_Rank;
+    // Edges to higher ranked nodes, stored at their tail and used by the forward search.
+    std::vector<int> m_UpFirst;
+    std::vector<Edge> m_Up;
+    // Edges from higher ranked nodes, stored at their head with the tail in Edge::head and
+    // used by the backward search.
+    std::vector<int> m_DownFirst;
+    std::vector<Edge> m_Down;
+    int m_ShortcutCount = 0;
+    int m_GraphEdgeCount = 0;
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef COST_POLICY_H
+#define COST_POLICY_H
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include "model.h"
+#include "route_graph.h"
+
+// Cost policies for BasicRoutePlanner. A policy gives the cost of a road graph edge and turns a
+// lower bound on the remaining distance in meters into a lower bound on the remaining cost, which
+// keeps the A* heuristics admissible. Both are plain member calls, resolved at compile time.
+
+// Shortest routes: the cost of an edge is its length in meters.
+struct DistanceCost {
+    float EdgeCost(const RouteGraph::Adjacency &edges, int e) const { return edges.weight[e]; }
+    float CostOfMeters(float meters) const { return meters; }
+};
+
+// Fastest routes: the cost of an edge is its free-flow travel time in seconds, at the driving
+// speed of its road type for cars and at walking speed on every road on foot, the same as
+// RouteGraph::TravelTimes(). A planner only accepts the policy for the profile it plans on.
+class TravelTimeCost {
+  public:
+    explicit TravelTimeCost(RouteGraph::Profile profile = RouteGraph::Profile::Car) : m_Profile(profile) {
+        for (int type = 0; type < static_cast<int>(m_SecondsPerMeter.size()); ++type) {
+            const auto road = profile == RouteGraph::Profile::Foot ? Model::Road::Footway : static_cast<Model::Road::Type>(type);
+            m_SecondsPerMeter[type] = 3.6f / RouteGraph::SpeedKmh(road);
+        }
+        m_MinSecondsPerMeter = *std::min_element(m_SecondsPerMeter.begin(), m_SecondsPerMeter.end());
+    }
+
+    RouteGraph::Profile GetProfile() const { return m_Profile; }
+    float EdgeCost(const RouteGraph::Adjacency &edges, int e) const {
+        return edges.weight[e] * m_SecondsPerMeter[edges.type[e]];
+    }
+    // No road is faster than the fastest road type.
+    float CostOfMeters(float meters) const { return meters * m_MinSecondsPerMeter; }
+
+  private:
+    RouteGraph::Profile m_Profile;
+    std::array<float, Model::Road::Footway + 1> m_SecondsPerMeter;
+    float m_MinSecondsPerMeter;
+};
+
+// Caller supplied cost of every Forward() edge, e.g. from a live traffic feed. The heuristics
+// assume no edge costs less than min_cost_per_meter times its length; 0 is always safe.
+struct CustomCost {
+    const std::vector<float> *costs = nullptr;
+    float min_cost_per_meter = 0.0f;
+
+    float EdgeCost(const RouteGraph::Adjacency &edges, int e) const { return (*costs)[edges.ForwardEdge(e)]; }
+    float CostOfMeters(float meters) const { return meters * min_cost_per_meter; }
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "delta_stepping.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace {
+// Frontiers smaller than this are relaxed on the calling thread; handing them to the pool
+// costs more than it saves.
+constexpr int kParallelThreshold = 256;
+constexpr int kGrain = 64;
+// Narrower buckets only add empty rounds.
+constexpr float kMinDelta = 0.1f;
+}  // namespace
+
+DeltaStepping::DeltaStepping(const RouteGraph &graph, float delta, int thread_count) :
+    m_Graph(graph), m_Delta(std::max(delta, kMinDelta)), m_Pool(thread_count),
+    m_Tentative(new std::atomic<float>[graph.NodeCount()]),
+    m_Improved(m_Pool.Size() + 1), m_Stamp(graph.NodeCount(), 0) {
+    SplitEdges();
+}
+
+void DeltaStepping::SetDelta(float delta) {
+    m_Delta = std::max(delta, kMinDelta);
+    SplitEdges();
+}
+
+void DeltaStepping::SplitEdges() {
+    const auto &edges = m_Graph.Forward();
+    m_Head.resize(edges.head.size());
+    m_Weight.resize(edges.weight.size());
+    m_LightEnd.resize(m_Graph.NodeCount());
+    for (int u = 0; u < m_Graph.NodeCount(); ++u) {
+        std::vector<int> order(edges.End(u) - edges.Begin(u));
+        std::iota(order.begin(), order.end(), edges.Begin(u));
+        auto heavy = std::stable_partition(order.begin(), order.end(), [&](int e) { return edges.weight[e] <= m_Delta; });
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            m_Head[edges.Begin(u) + i] = edges.head[order[i]];
+            m_Weight[edges.Begin(u) + i] = edges.weight[order[i]];
+        }
+        m_LightEnd[u] = edges.Begin(u) + static_cast<int>(heavy - order.begin());
+    }
+}
+
+// Lower the tentative distance of v to distance if that is an improvement, from any thread.
+bool DeltaStepping::TryImprove(int v, float distance) {
+    float current = m_Tentative[v].load(std::memory_order_relaxed);
+    while (distance < current) {
+        if (m_Tentative[v].compare_exchange_weak(current, distance, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Range>
+void DeltaStepping::Relax(const std::vector<int> &nodes, Range range) {
+    auto relax_node = [&](int u, std::vector<int> &improved) {
+        float distance = m_Tentative[u].load(std::memory_order_relaxed);
+        auto [begin, end] = range(u);
+        for (int e = begin; e < end; ++e) {
+            if (TryImprove(m_Head[e], distance + m_Weight[e])) {
+                improved.push_back(m_Head[e]);
+            }
+        }
+    };
+    if (static_cast<int>(nodes.size()) < kParallelThreshold || m_Pool.Size() == 1) {
+        for (int u : nodes) {
+            relax_node(u, m_Improved.back());
+        }
+        return;
+    }
+    m_Pool.ParallelFor(static_cast<int>(nodes.size()), [&](int i, int worker) {
+        relax_node(nodes[i], m_Improved[worker]);
+    }, kGrain);
+}
+
+const std::vector<float> &DeltaStepping::Run(int source) {
+    const int node_count = m_Graph.NodeCount();
+    constexpr float kInfinity = std::numeric_limits<float>::infinity();
+    for (int v = 0; v < node_count; ++v) {
+        m_Tentative[v].store(kInfinity, std::memory_order_relaxed);
+    }
+    m_Tentative[source].store(0.0f, std::memory_order_relaxed);
+
+    std::vector<std::vector<int>> buckets(1, std::vector<int>{source});
+    auto merge_improved = [&] {
+        for (auto &improved : m_Improved) {
+            for (int v : improved) {
+                std::size_t bucket = Bucket(m_Tentative[v].load(std::memory_order_relaxed));
+                if (bucket >= buckets.size()) {
+                    buckets.resize(bucket + 1);
+                }
+                buckets[bucket].push_back(v);
+            }
+            improved.clear();
+        }
+    };
+
+    std::vector<int> frontier;
+    std::vector<int> settled;
+    std::size_t i = 0;
+    while (i < buckets.size()) {
+        settled.clear();
+        while (!buckets[i].empty()) {
+            // Stamps drop duplicates and nodes that have since moved to a lower bucket.
+            if (++m_Generation == 0) {
+                std::fill(m_Stamp.begin(), m_Stamp.end(), 0);
+                m_Generation = 1;
+            }
+            frontier.clear();
+            for (int v : buckets[i]) {
+                if (m_Stamp[v] != m_Generation && Bucket(m_Tentative[v].load(std::memory_order_relaxed)) == i) {
+                    m_Stamp[v] = m_Generation;
+                    frontier.push_back(v);
+                }
+            }
+            buckets[i].clear();
+            settled.insert(settled.end(), frontier.begin(), frontier.end());
+            Relax(frontier, [&](int u) { return std::make_pair(m_Graph.Forward().Begin(u), m_LightEnd[u]); });
+            merge_improved();
+        }
+        // Heavy edges lead to a later bucket, so one pass over the settled nodes suffices.
+        std::sort(settled.begin(), settled.end());
+        settled.erase(std::unique(settled.begin(), settled.end()), settled.end());
+        Relax(settled, [&](int u) { return std::make_pair(m_LightEnd[u], m_Graph.Forward().End(u)); });
+        merge_improved();
+        // Rounding can still drop a heavy edge into bucket i; move on only once it stays empty.
+        if (buckets[i].empty()) {
+            ++i;
+        }
+    }
+
+    m_Distance.resize(node_count);
+    for (int v = 0; v < node_count; ++v) {
+        m_Distance[v] = m_Tentative[v].load(std::memory_order_relaxed);
+    }
+    return m_Distance;
+}
@@ -0,0 +1,50 @@
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "route_graph.h"
+#include "thread_pool.h"
+
+// Parallel single-source shortest paths by delta-stepping. Nodes are kept in buckets of width
+// delta meters; all nodes of the lowest bucket are relaxed at once across the thread pool, light
+// edges (at most delta long) until the bucket stays empty, then heavy edges once. Every worker
+// collects the nodes it improved in its own buffer, which are merged into the buckets between
+// phases. A small delta does less redundant work, a large one exposes more parallelism.
+class DeltaStepping {
+  public:
+    DeltaStepping(const RouteGraph &graph, float delta = 50.0f, int thread_count = 0);
+
+    float Delta() const { return m_Delta; }
+    void SetDelta(float delta);
+    int ThreadCount() const { return m_Pool.Size(); }
+
+    // Distances in meters from source to every node, infinity where there is no route. The
+    // result is overwritten by the next Run().
+    const std::vector<float> &Run(int source);
+
+  private:
+    void SplitEdges();
+    // Relax the edges [begin(u), end(u)) of every node in nodes, in parallel for large sets.
+    template <typename Range>
+    void Relax(const std::vector<int> &nodes, Range range);
+    bool TryImprove(int v, float distance);
+    std::size_t Bucket(float distance) const { return static_cast<std::size_t>(distance / m_Delta); }
+
+    const RouteGraph &m_Graph;
+    float m_Delta;
+    ThreadPool m_Pool;
+    // Copy of the forward edges with the light edges of every node in front of its heavy ones.
+    std::vector<int> m_Head;
+    std::vector<float> m_Weight;
+    std::vector<int> m_LightEnd;
+    std::unique_ptr<std::atomic<float>[]> m_Tentative;
+    // Nodes improved by each worker during a phase; the last one belongs to the calling thread.
+    std::vector<std::vector<int>> m_Improved;
+    std::vector<unsigned int> m_Stamp;
+    unsigned int m_Generation = 0;
+    std::vector<float> m_Distance;
+};
+
+#endif
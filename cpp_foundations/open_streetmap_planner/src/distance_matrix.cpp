@@ -0,0 +1,103 @@
+#include "distance_matrix.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
+
+namespace {
+
+// Rows computed per worker thread before they are handed to the callback.
+constexpr int kRowsPerThread = 16;
+
+struct BucketEntry {
+    int target;
+    float distance;
+};
+
+}  // namespace
+
+DistanceMatrix::DistanceMatrix(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count) :
+    m_Model(model), m_Hierarchy(hierarchy),
+    m_ThreadCount(thread_count > 0 ? thread_count : std::max(1u, std::thread::hardware_concurrency())) {}
+
+std::vector<int> DistanceMatrix::Snap(const std::vector<Point> &points) const {
+    std::vector<int> nodes;
+    nodes.reserve(points.size());
+    for (const Point &point : points) {
+        nodes.push_back(m_Model.FindClosestNode(point.x * 0.01f, point.y * 0.01f).Index());
+    }
+    return nodes;
+}
+
+void DistanceMatrix::Stream(const std::vector<int> &sources, const std::vector<int> &targets,
+                            const RowCallback &callback) const {
+    const int node_count = m_Hierarchy.NodeCount();
+    const int columns = static_cast<int>(targets.size());
+
+    // Backward search from every target, collected into buckets stored as CSR by node.
+    std::vector<int> bucket_first(node_count + 1, 0);
+    std::vector<BucketEntry> buckets;
+    {
+        std::vector<std::pair<int, float>> settled;
+        std::vector<std::pair<int, BucketEntry>> entries;
+        SearchSpace space{node_count};
+        for (int j = 0; j < columns; ++j) {
+            settled.clear();
+            m_Hierarchy.UpwardSearch(targets[j], false, space, settled);
+            for (const auto &[node, distance] : settled) {
+                entries.push_back({node, {j, distance}});
+                bucket_first[node + 1]++;
+            }
+        }
+        for (int v = 0; v < node_count; ++v) {
+            bucket_first[v + 1] += bucket_first[v];
+        }
+        buckets.resize(entries.size());
+        std::vector<int> fill(bucket_first.begin(), bucket_first.end() - 1);
+        for (const auto &[node, entry] : entries) {
+            buckets[fill[node]++] = entry;
+        }
+    }
+
+    // Forward searches fill a block of rows in parallel; the block is then streamed in order.
+    const int block_rows = m_ThreadCount * kRowsPerThread;
+    std::vector<float> block(static_cast<std::size_t>(block_rows) * columns);
+    std::vector<SearchSpace> spaces(m_ThreadCount, SearchSpace{node_count});
+    for (int block_begin = 0; block_begin < static_cast<int>(sources.size()); block_begin += block_rows) {
+        const int block_end = std::min<int>(block_begin + block_rows, sources.size());
+        std::fill(block.begin(), block.end(), std::numeric_limits<float>::infinity());
+        std::atomic<int> next_row{block_begin};
+        auto worker = [&](int thread) {
+            std::vector<std::pair<int, float>> settled;
+            for (int i = next_row++; i < block_end; i = next_row++) {
+                float *row = block.data() + static_cast<std::size_t>(i - block_begin) * columns;
+                settled.clear();
+                m_Hierarchy.UpwardSearch(sources[i], true, spaces[thread], settled);
+                for (const auto &[node, distance] : settled) {
+                    for (int b = bucket_first[node]; b < bucket_first[node + 1]; ++b) {
+                        row[buckets[b].target] = std::min(row[buckets[b].target], distance + buckets[b].distance);
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (int t = 1; t < m_ThreadCount && t * kRowsPerThread < block_end - block_begin; ++t) {
+            threads.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        for (int i = block_begin; i < block_end; ++i) {
+            callback(i, block.data() + static_cast<std::size_t>(i - block_begin) * columns);
+        }
+    }
+}
+
+std::vector<float> DistanceMatrix::Compute(const std::vector<int> &sources, const std::vector<int> &targets) const {
+    std::vector<float> table(sources.size() * targets.size());
+    Stream(sources, targets, [&](int row, const float *distances) {
+        std::copy(distances, distances + targets.size(), table.begin() + static_cast<std::size_t>(row) * targets.size());
+    });
+    return table;
+}
@@ -0,0 +1,38 @@
+#ifndef DISTANCE_MATRIX_H
+#define DISTANCE_MATRIX_H
+
+#include <functional>
+#include <vector>
+#include "contraction_hierarchy.h"
+#include "route_model.h"
+
+// Many-to-many shortest distances with the bucket algorithm on a contraction hierarchy. Every
+// target leaves its backward search space in per-node buckets, then every source scans the
+// buckets of the nodes in its forward search space. Rows are computed in parallel.
+class DistanceMatrix {
+  public:
+    // A point in percent of the map, like the RoutePlanner endpoints.
+    struct Point {
+        float x;
+        float y;
+    };
+    // Receives one finished row: the distances in meters from one source to every target,
+    // infinity where there is no route.
+    using RowCallback = std::function<void(int row, const float *distances)>;
+
+    DistanceMatrix(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count = 0);
+
+    // Snap every point to its closest road node once, so it can be used in any number of rows.
+    std::vector<int> Snap(const std::vector<Point> &points) const;
+    // Compute the table block by block and hand the rows over in order on the calling thread.
+    void Stream(const std::vector<int> &sources, const std::vector<int> &targets, const RowCallback &callback) const;
+    // Whole table, row major, sources by targets.
+    std::vector<float> Compute(const std::vector<int> &sources, const std::vector<int> &targets) const;
+
+  private:
+    RouteModel &m_Model;
+    const ContractionHierarchy &m_Hierarchy;
+    int m_ThreadCount;
+};
+
+#endif
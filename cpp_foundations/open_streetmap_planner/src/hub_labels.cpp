@@ -0,0 +1,174 @@
+#include "hub_labels.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+// Reads one label of a LabelSet, decoding the hub gaps on the fly.
+class LabelCursor {
+  public:
+    LabelCursor(const std::uint8_t *hubs, const float *distances, const float *distances_end) :
+        m_Hubs(hubs), m_Distances(distances), m_End(distances_end) {
+        Next();
+    }
+
+    bool Done() const { return m_Done; }
+    int Hub() const { return m_Hub; }
+    float Distance() const { return m_Distances[-1]; }
+
+    void Next() {
+        if (m_Distances == m_End) {
+            m_Done = true;
+            return;
+        }
+        int gap = 0;
+        int shift = 0;
+        std::uint8_t byte = 0;
+        do {
+            byte = *m_Hubs++;
+            gap |= (byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        m_Hub += gap;
+        ++m_Distances;
+    }
+
+  private:
+    const std::uint8_t *m_Hubs;
+    const float *m_Distances;
+    const float *m_End;
+    int m_Hub = 0;
+    bool m_Done = false;
+};
+
+}  // namespace
+
+HubLabels::HubLabels(const ContractionHierarchy &hierarchy) {
+    const int node_count = hierarchy.NodeCount();
+    std::vector<int> by_rank(node_count);
+    for (int v = 0; v < node_count; ++v) {
+        by_rank[hierarchy.Rank(v)] = v;
+    }
+
+    std::vector<Label> forward(node_count);
+    std::vector<Label> backward(node_count);
+    auto build = [&](int v, bool is_forward) {
+        // Start from the labels of the higher neighbors, which are already final.
+        Label label{{hierarchy.Rank(v), 0.0f}};
+        auto edges = is_forward ? hierarchy.UpwardEdges(v) : hierarchy.DownwardEdges(v);
+        for (const auto &edge : edges) {
+            for (const auto &[hub, distance] : (is_forward ? forward : backward)[edge.head]) {
+                label.emplace_back(hub, distance + edge.weight);
+            }
+        }
+        std::sort(label.begin(), label.end());
+        label.erase(std::unique(label.begin(), label.end(),
+                                [](const auto &a, const auto &b) { return a.first == b.first; }), label.end());
+
+        // Drop entries that are not shortest distances: some other hub already does better.
+        Label pruned;
+        for (const auto &[hub, distance] : label) {
+            int hub_node = by_rank[hub];
+            float other = hub_node == v ? kInfinity :
+                          is_forward ? Join(label, backward[hub_node], hub) : Join(forward[hub_node], label, hub);
+            if (other >= distance) {
+                pruned.emplace_back(hub, distance);
+            }
+        }
+        return pruned;
+    };
+    for (int rank = node_count - 1; rank >= 0; --rank) {
+        int v = by_rank[rank];
+        forward[v] = build(v, true);
+        backward[v] = build(v, false);
+    }
+
+    for (auto *set : {&m_Forward, &m_Backward}) {
+        set->entry_offset.push_back(0);
+        set->hub_offset.push_back(0);
+    }
+    for (int v = 0; v < node_count; ++v) {
+        Append(m_Forward, forward[v]);
+        Label().swap(forward[v]);
+        Append(m_Backward, backward[v]);
+        Label().swap(backward[v]);
+    }
+}
+
+void HubLabels::Append(LabelSet &set, const Label &label) {
+    int previous = 0;
+    for (const auto &[hub, distance] : label) {
+        unsigned int gap = hub - previous;
+        previous = hub;
+        do {
+            std::uint8_t byte = gap & 0x7f;
+            gap >>= 7;
+            set.hubs.push_back(gap ? (byte | 0x80) : byte);
+        } while (gap);
+        set.distances.push_back(distance);
+    }
+    set.entry_offset.push_back(set.distances.size());
+    set.hub_offset.push_back(set.hubs.size());
+}
+
+// Merge join of two uncompressed labels, ignoring one hub.
+float HubLabels::Join(const Label &forward, const Label &backward, int skipped_hub) {
+    float best = kInfinity;
+    auto f = forward.begin();
+    auto b = backward.begin();
+    while (f != forward.end() && b != backward.end()) {
+        if (f->first < b->first) {
+            ++f;
+        } else if (b->first < f->first) {
+            ++b;
+        } else {
+            if (f->first != skipped_hub) {
+                best = std::min(best, f->second + b->second);
+            }
+            ++f;
+            ++b;
+        }
+    }
+    return best;
+}
+
+float HubLabels::Distance(int source, int target) const {
+    LabelCursor f{m_Forward.hubs.data() + m_Forward.hub_offset[source],
+                  m_Forward.distances.data() + m_Forward.entry_offset[source],
+                  m_Forward.distances.data() + m_Forward.entry_offset[source + 1]};
+    LabelCursor b{m_Backward.hubs.data() + m_Backward.hub_offset[target],
+                  m_Backward.distances.data() + m_Backward.entry_offset[target],
+                  m_Backward.distances.data() + m_Backward.entry_offset[target + 1]};
+    float best = kInfinity;
+    while (!f.Done() && !b.Done()) {
+        if (f.Hub() < b.Hub()) {
+            f.Next();
+        } else if (b.Hub() < f.Hub()) {
+            b.Next();
+        } else {
+            best = std::min(best, f.Distance() + b.Distance());
+            f.Next();
+            b.Next();
+        }
+    }
+    return best;
+}
+
+double HubLabels::AverageLabelSize() const {
+    int node_count = NodeCount();
+    if (node_count == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(m_Forward.distances.size() + m_Backward.distances.size()) / (2.0 * node_count);
+}
+
+std::size_t HubLabels::MemoryBytes() const {
+    std::size_t bytes = 0;
+    for (const auto *set : {&m_Forward, &m_Backward}) {
+        bytes += set->entry_offset.size() * sizeof(std::uint64_t) + set->hub_offset.size() * sizeof(std::uint64_t) +
+                 set->hubs.size() + set->distances.size() * sizeof(float);
+    }
+    return bytes;
+}
@@ -0,0 +1,42 @@
+#ifndef HUB_LABELS_H
+#define HUB_LABELS_H
+
+#include <cstdint>
+#include <vector>
+#include "contraction_hierarchy.h"
+
+// Hub labeling distance oracle. Every node gets a forward label (hubs it can reach, with the
+// distance) and a backward label (hubs that reach it). The shortest distance from s to t is the
+// minimum of d(s, h) + d(h, t) over the hubs h the two labels share, found by a merge join.
+class HubLabels {
+  public:
+    // Derive the labels from the search spaces of a contraction hierarchy, top rank first,
+    // dropping every entry that the labels built so far already beat.
+    HubLabels(const ContractionHierarchy &hierarchy);
+
+    int NodeCount() const { return static_cast<int>(m_Forward.entry_offset.size()) - 1; }
+    // Shortest distance in meters, or infinity if there is no route.
+    float Distance(int source, int target) const;
+
+    double AverageLabelSize() const;
+    std::size_t MemoryBytes() const;
+
+  private:
+    // Labels stored back to back. Hubs are identified by rank, sorted ascending and varint
+    // encoded as gaps; distances are kept as plain floats next to them.
+    struct LabelSet {
+        std::vector<std::uint64_t> entry_offset;
+        std::vector<std::uint64_t> hub_offset;
+        std::vector<std::uint8_t> hubs;
+        std::vector<float> distances;
+    };
+    using Label = std::vector<std::pair<int, float>>;
+
+    static void Append(LabelSet &set, const Label &label);
+    static float Join(const Label &forward, const Label &backward, int skipped_hub);
+
+    LabelSet m_Forward;
+    LabelSet m_Backward;
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include "landmarks.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <random>
+#include <thread>
+
+namespace {
+
+constexpr std::uint16_t kUnreachable = std::numeric_limits<std::uint16_t>::max();
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+
+struct ShortestPathTree {
+    std::vector<float> distance;
+    std::vector<int> parent;
+    std::vector<int> settle_order;
+};
+
+ShortestPathTree Dijkstra(const RouteGraph::Adjacency &graph, int source) {
+    using Entry = std::pair<float, int>;
+    const int node_count = static_cast<int>(graph.first_out.size()) - 1;
+    ShortestPathTree tree{std::vector<float>(node_count, kInfinity), std::vector<int>(node_count, -1), {}};
+    std::vector<bool> settled(node_count, false);
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    tree.distance[source] = 0.0f;
+    queue.emplace(0.0f, source);
+    while (!queue.empty()) {
+        auto [distance, u] = queue.top();
+        queue.pop();
+        if (settled[u]) {
+            continue;
+        }
+        settled[u] = true;
+        tree.settle_order.push_back(u);
+        for (int e = graph.Begin(u); e < graph.End(u); ++e) {
+            int v = graph.head[e];
+            if (distance + graph.weight[e] < tree.distance[v]) {
+                tree.distance[v] = distance + graph.weight[e];
+                tree.parent[v] = u;
+                queue.emplace(tree.distance[v], v);
+            }
+        }
+    }
+    return tree;
+}
+
+// Node with the most road edges, used to seed the landmark selection deterministically.
+int BusiestNode(const RouteGraph &graph) {
+    int best = 0;
+    for (int v = 0; v < graph.NodeCount(); ++v) {
+        const auto &forward = graph.Forward();
+        if (forward.End(v) - forward.Begin(v) > forward.End(best) - forward.Begin(best)) {
+            best = v;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+Landmarks::Landmarks(const RouteGraph &graph, int count, Selection selection) : m_Profile(graph.GetProfile()) {
+    if (graph.EdgeCount() == 0 || count <= 0) {
+        return;
+    }
+    if (selection == Selection::Farthest) {
+        SelectFarthest(graph, count);
+    } else {
+        SelectAvoid(graph, count);
+    }
+    ComputeTables(graph);
+}
+
+void Landmarks::SelectFarthest(const RouteGraph &graph, int count) {
+    // Start from the node farthest from a central one, then keep adding the node whose
+    // distance to the closest landmark so far is largest.
+    std::vector<float> closest = Dijkstra(graph.Forward(), BusiestNode(graph)).distance;
+    while (static_cast<int>(m_Landmarks.size()) < count) {
+        int farthest = -1;
+        for (int v = 0; v < graph.NodeCount(); ++v) {
+            if (closest[v] != kInfinity && closest[v] > 0.0f && (farthest == -1 || closest[v] > closest[farthest])) {
+                farthest = v;
+            }
+        }
+        if (farthest == -1) {
+            break;
+        }
+        if (m_Landmarks.empty()) {
+            std::fill(closest.begin(), closest.end(), kInfinity);
+        }
+        m_Landmarks.push_back(farthest);
+        auto distance = Dijkstra(graph.Forward(), farthest).distance;
+        for (int v = 0; v < graph.NodeCount(); ++v) {
+            closest[v] = std::min(closest[v], distance[v]);
+        }
+    }
+}
+
+void Landmarks::SelectAvoid(const RouteGraph &graph, int count) {
+    const int node_count = graph.NodeCount();
+    std::vector<std::vector<float>> from_landmark;
+    std::mt19937 rng{20240601};
+    std::vector<int> road_nodes;
+    for (int v = 0; v < node_count; ++v) {
+        if (graph.Forward().End(v) > graph.Forward().Begin(v)) {
+            road_nodes.push_back(v);
+        }
+    }
+
+    int attempts = 0;
+    while (static_cast<int>(m_Landmarks.size()) < count && attempts++ < 4 * count) {
+        // Grow a shortest path tree from a random root.
+        int root = m_Landmarks.empty() ? BusiestNode(graph) : road_nodes[rng() % road_nodes.size()];
+        auto tree = Dijkstra(graph.Forward(), root);
+
+        // Weight each node by how far the current bound from the root falls short of the real
+        // distance, and sum the weights over every subtree that holds no landmark yet.
+        std::vector<double> size(node_count, 0.0);
+        std::vector<bool> covered(node_count, false);
+        for (int landmark : m_Landmarks) {
+            covered[landmark] = true;
+        }
+        for (auto it = tree.settle_order.rbegin(); it != tree.settle_order.rend(); ++it) {
+            int v = *it;
+            float bound = 0.0f;
+            for (const auto &distance : from_landmark) {
+                if (distance[root] != kInfinity && distance[v] != kInfinity) {
+                    bound = std::max(bound, distance[v] - distance[root]);
+                }
+            }
+            size[v] = covered[v] ? 0.0 : size[v] + tree.distance[v] - bound;
+            if (int parent = tree.parent[v]; parent != -1) {
+                size[parent] += size[v];
+                covered[parent] = covered[parent] || covered[v];
+            }
+        }
+
+        // Walk down from the root along the heaviest subtree; the leaf becomes the landmark.
+        std::vector<std::vector<int>> children(node_count);
+        for (int v : tree.settle_order) {
+            if (tree.parent[v] != -1) {
+                children[tree.parent[v]].push_back(v);
+            }
+        }
+        int v = root;
+        while (!children[v].empty()) {
+            int heaviest = *std::max_element(children[v].begin(), children[v].end(),
+                                             [&](int a, int b) { return size[a] < size[b]; });
+            if (size[heaviest] <= 0.0) {
+                break;
+            }
+            v = heaviest;
+        }
+        if (v == root || size[v] <= 0.0 || std::find(m_Landmarks.begin(), m_Landmarks.end(), v) != m_Landmarks.end()) {
+            continue;
+        }
+        m_Landmarks.push_back(v);
+        from_landmark.push_back(Dijkstra(graph.Forward(), v).distance);
+    }
+}
+
+void Landmarks::ComputeTables(const RouteGraph &graph) {
+    const int count = static_cast<int>(m_Landmarks.size());
+    const int node_count = graph.NodeCount();
+    // Job 2 * i runs from landmark i over the forward graph and job 2 * i + 1 to it over the
+    // backward graph. Each job writes its own column of the table.
+    std::vector<std::vector<float>> distances(2 * count);
+    auto run_jobs = [&](const RouteGraph::Adjacency &forward, const RouteGraph::Adjacency &backward) {
+        std::atomic<int> next_job{0};
+        auto worker = [&]() {
+            for (int job = next_job++; job < 2 * count; job = next_job++) {
+                distances[job] = Dijkstra(job % 2 == 0 ? forward : backward, m_Landmarks[job / 2]).distance;
+            }
+        };
+        int thread_count = std::max(1, std::min<int>(std::thread::hardware_concurrency(), 2 * count));
+        std::vector<std::thread> threads;
+        for (int i = 1; i < thread_count; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    };
+    run_jobs(graph.Forward(), graph.Backward());
+
+    // Quantize to 16 bits. Rounding each distance down would keep the bounds admissible but not
+    // consistent, so the tables instead hold distances over edge lengths rounded down to whole
+    // units. Those are at most the real distances and differ by at most the rounded length across
+    // any edge, which keeps the bounds consistent without giving up a unit in LowerBound().
+    float max_distance = 0.0f;
+    for (const auto &column : distances) {
+        for (float distance : column) {
+            if (distance != kInfinity) {
+                max_distance = std::max(max_distance, distance);
+            }
+        }
+    }
+    m_Unit = std::max(max_distance / (kUnreachable - 1), 1e-3f);
+    auto in_units = [&](RouteGraph::Adjacency adjacency) {
+        for (float &weight : adjacency.weight) {
+            weight = std::floor(weight / m_Unit);
+        }
+        return adjacency;
+    };
+    run_jobs(in_units(graph.Forward()), in_units(graph.Backward()));
+
+    m_Table.assign(static_cast<std::size_t>(node_count) * 2 * count, kUnreachable);
+    for (int v = 0; v < node_count; ++v) {
+        for (int job = 0; job < 2 * count; ++job) {
+            float distance = distances[job][v];
+            if (distance != kInfinity) {
+                m_Table[static_cast<std::size_t>(v) * 2 * count + job] =
+                    static_cast<std::uint16_t>(std::min<float>(distance, kUnreachable - 1));
+            }
+        }
+    }
+}
+
+float Landmarks::LowerBound(int from, int to) const {
+    const int entries = 2 * static_cast<int>(m_Landmarks.size());
+    if (entries == 0) {
+        return 0.0f;
+    }
+    const std::uint16_t *from_row = m_Table.data() + static_cast<std::size_t>(from) * entries;
+    const std::uint16_t *to_row = m_Table.data() + static_cast<std::size_t>(to) * entries;
+    // Stored values are distances in whole units over rounded down edge lengths, see ComputeTables().
+    int best = 0;
+    for (int i = 0; i < entries; i += 2) {
+        if (from_row[i] != kUnreachable && to_row[i] != kUnreachable) {
+            best = std::max(best, to_row[i] - from_row[i]);
+        }
+        if (from_row[i + 1] != kUnreachable && to_row[i + 1] != kUnreachable) {
+            best = std::max(best, from_row[i + 1] - to_row[i + 1]);
+        }
+    }
+    return best * m_Unit;
+}
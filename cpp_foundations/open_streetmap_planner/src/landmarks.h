@@ -0,0 +1,46 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <cstdint>
+#include <vector>
+#include "route_graph.h"
+
+// Landmark distance tables for the ALT (A*, landmarks, triangle inequality) heuristic. For a
+// landmark L the triangle inequality gives d(v, t) >= d(L, t) - d(L, v) and
+// d(v, t) >= d(v, L) - d(t, L), which is usually much tighter than the straight-line distance.
+class Landmarks {
+  public:
+    enum class Selection {
+        Farthest,  // Each landmark is the node farthest from the ones picked so far.
+        Avoid,     // Landmarks are placed where the current bounds are worst (Goldberg and Werneck).
+    };
+
+    // Select the landmarks and compute their distance tables, one Dijkstra per thread.
+    Landmarks(const RouteGraph &graph, int count = 16, Selection selection = Selection::Avoid);
+
+    const std::vector<int> &Nodes() const { return m_Landmarks; }
+    // Profile of the graph the tables were built on; the bounds only hold on that graph.
+    RouteGraph::Profile GetProfile() const { return m_Profile; }
+    // Lower bound on the road distance in meters from one node to another. It is consistent, so
+    // searches using it never need to reopen a settled node.
+    float LowerBound(int from, int to) const;
+    std::size_t TableBytes() const { return m_Table.size() * sizeof(m_Table[0]); }
+
+  private:
+    void SelectFarthest(const RouteGraph &graph, int count);
+    void SelectAvoid(const RouteGraph &graph, int count);
+    void ComputeTables(const RouteGraph &graph);
+
+    RouteGraph::Profile m_Profile;
+    std::vector<int> m_Landmarks;
+    // Node major table: for node v and landmark i, entry 2 * (v * count + i) holds d(L_i, v) and
+    // the next one d(v, L_i), both in units of m_Unit over edge lengths rounded down to whole units.
+    std::vector<std::uint16_t> m_Table;
+    // The longest distance from or to a landmark over 65534, so a meter or more on maps over 65 km
+    // across. Rounding each edge down makes a bound at most one unit per edge of the path lower than
+    // with exact tables, but never higher than the real distance or than the length of an edge plus
+    // the bound at its head, which a bidirectional search stopping on the sum of its keys relies on.
+    float m_Unit = 1.0f;
+};
+
+#endif
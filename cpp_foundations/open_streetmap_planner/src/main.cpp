@@ -1,3 +1,8 @@
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <future>
+#include <memory>
 #include <optional>
 #include <fstream>
 #include <iostream>
@@ -7,6 +12,8 @@
 #include "route_model.h"
 #include "render.h"
 #include "route_planner.h"
+#include "batch_router.h"
+#include "route_server.h"
 
 using namespace std::experimental;
 
@@ -31,60 +38,352 @@ bool verify_percent(float percentage){
   return (percentage >= 0. && percentage <= 100.);
 }
 
+// Read the coordinates of one endpoint, name being "start" or "end".
+void ReadPoint(const std::string &name, float &x, float &y){
+    bool is_percent = false;
+    while (!is_percent){
+      std::cout << "Enter " << name << "_x (percent): ";
+      std::cin >> x;
+      std::cout << "Enter " << name << "_y (percent): ";
+      std::cin >> y;
+      is_percent = (verify_percent(x) && verify_percent(y));
+      if (!is_percent){
+        std::cout << "Try again. All numbers must be between 0 and 100\n";
+      }
+    }
+}
+
+void ReadEndpoints(float &start_x, float &start_y, float &end_x, float &end_y){
+    ReadPoint("start", start_x, start_y);
+    ReadPoint("end", end_x, end_y);
+}
+
+bool AskYesNo(const std::string &question){
+    std::string answer;
+    std::cout << question;
+    return (std::cin >> answer) && (answer == "y" || answer == "Y");
+}
+
+// Load a contraction hierarchy from ch_file, or build it and save it there for the next run.
+static ContractionHierarchy LoadOrBuildHierarchy(const RouteGraph &graph, const std::string &ch_file)
+{
+    if( !ch_file.empty() )
+        if( auto hierarchy = ContractionHierarchy::Load(ch_file, graph) )
+            return std::move(*hierarchy);
+    std::cerr << "Building contraction hierarchy." << std::endl;
+    ContractionHierarchy hierarchy{graph};
+    if( !ch_file.empty() && !hierarchy.Save(ch_file) )
+        std::cerr << "Failed to write " << ch_file << std::endl;
+    return hierarchy;
+}
+
+// Answer every query of batch_file ("-" for stdin) without prompts or rendering.
+static int RunBatch(const std::vector<std::byte> &osm_data, const std::string &batch_file, const std::string &ch_file,
+                    const std::string &output_file, bool binary_output, int thread_count, int cache_mb,
+                    bool show_stats)
+{
+    std::vector<BatchRouter::Query> queries;
+    if( batch_file == "-" )
+        queries = BatchRouter::ReadQueries(std::cin);
+    else {
+        std::ifstream is{batch_file};
+        if( !is ) {
+            std::cerr << "Failed to read " << batch_file << std::endl;
+            return 1;
+        }
+        queries = BatchRouter::ReadQueries(is);
+    }
+
+    RouteModel model{osm_data};
+    ContractionHierarchy hierarchy = LoadOrBuildHierarchy(model.Graph(), ch_file);
+    BatchRouter router{model, hierarchy, thread_count};
+    std::optional<RouteCache> cache;
+    if( cache_mb > 0 ) {
+        cache.emplace(static_cast<std::size_t>(cache_mb) << 20);
+        router.SetCache(&*cache);
+    }
+    auto results = router.Run(queries);
+
+    std::ofstream file;
+    if( !output_file.empty() )
+        file.open(output_file, binary_output ? std::ios::binary : std::ios::out);
+    std::ostream &os = output_file.empty() ? std::cout : file;
+    if( binary_output )
+        BatchRouter::WriteBinary(os, results);
+    else
+        BatchRouter::WriteCsv(os, results);
+
+    const auto &summary = router.LastSummary();
+    std::cerr << "Answered " << summary.queries << " queries in " << summary.seconds << " s ("
+              << summary.queries_per_second << " queries/s), p50 " << summary.p50_us << " us, p99 "
+              << summary.p99_us << " us, " << summary.cache_hits << " cache hits" << std::endl;
+    if( show_stats )
+        summary.search.Print(std::cerr);
+    return os ? 0 : 1;
+}
+
+static RouteServer *running_server = nullptr;
+
+// Serve route requests on address ("unix:/path" or "tcp:port") until SIGINT or SIGTERM. SIGHUP
+// reloads the map files.
+static int RunServer(const std::vector<std::byte> &osm_data, const std::string &osm_data_file,
+                     const std::string &address, const std::string &ch_file, int thread_count, int cache_mb)
+{
+    RouteModel model{osm_data};
+    ContractionHierarchy hierarchy = LoadOrBuildHierarchy(model.Graph(), ch_file);
+    std::optional<RouteCache> cache;
+    if( cache_mb > 0 )
+        cache.emplace(static_cast<std::size_t>(cache_mb) << 20);
+    RouteServer server{model, hierarchy, thread_count};
+    server.SetMapFiles(osm_data_file, ch_file);
+    if( cache )
+        server.SetCache(&*cache);
+    bool listening = false;
+    if( address.rfind("unix:", 0) == 0 )
+        listening = server.ListenUnix(address.substr(5));
+    else if( address.rfind("tcp:", 0) == 0 )
+        listening = server.ListenTcp(std::stoi(address.substr(4)));
+    if( !listening ) {
+        std::cerr << "Failed to listen on " << address << std::endl;
+        return 1;
+    }
+    std::cerr << "Serving routes on " << address;
+    if( server.Port() != 0 )
+        std::cerr << " (port " << server.Port() << ")";
+    std::cerr << std::endl;
+
+    running_server = &server;
+    auto stop = [](int) { running_server->Stop(); };
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+    std::signal(SIGHUP, [](int) { running_server->Reload(); });
+    server.Run();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+    std::signal(SIGHUP, SIG_DFL);
+    running_server = nullptr;
+    return 0;
+}
+
 int main(int argc, const char **argv)
 {    
     std::string osm_data_file = "";
+    std::string ch_file = "";
+    std::string batch_file = "";
+    std::string output_file = "";
+    std::string trace_file = "";
+    std::string serve_address = "";
+    bool binary_output = false;
+    int thread_count = 0;
+    int cache_mb = 0;
+    int landmark_count = 0;
+    float isochrone_m = 0.f;
+    bool fastest = false;
+    bool turns = false;
+    bool foot = false;
+    bool show_stats = false;
+    TurnCosts turn_costs;
     if( argc > 1 ) {
         for( int i = 1; i < argc; ++i )
             if( std::string_view{argv[i]} == "-f" && ++i < argc )
                 osm_data_file = argv[i];
+            else if( std::string_view{argv[i]} == "-ch" && ++i < argc )
+                ch_file = argv[i];
+            else if( std::string_view{argv[i]} == "-batch" && ++i < argc )
+                batch_file = argv[i];
+            else if( std::string_view{argv[i]} == "-serve" && ++i < argc )
+                serve_address = argv[i];
+            else if( std::string_view{argv[i]} == "-o" && ++i < argc )
+                output_file = argv[i];
+            else if( std::string_view{argv[i]} == "-binary" )
+                binary_output = true;
+            else if( std::string_view{argv[i]} == "-threads" && ++i < argc )
+                thread_count = std::stoi(argv[i]);
+            else if( std::string_view{argv[i]} == "-cache" && ++i < argc )
+                cache_mb = std::stoi(argv[i]);
+            else if( std::string_view{argv[i]} == "-fastest" )
+                fastest = true;
+            else if( std::string_view{argv[i]} == "-foot" )
+                foot = true;
+            else if( std::string_view{argv[i]} == "-turns" )
+                turns = true;
+            else if( std::string_view{argv[i]} == "-left-turn" && ++i < argc ) {
+                turns = true;
+                turn_costs.left = std::stof(argv[i]);
+            }
+            else if( std::string_view{argv[i]} == "-trace" && ++i < argc )
+                trace_file = argv[i];
+            else if( std::string_view{argv[i]} == "-stats" )
+                show_stats = true;
+            else if( std::string_view{argv[i]} == "-isochrone" && ++i < argc )
+                isochrone_m = std::stof(argv[i]);
+            else if( std::string_view{argv[i]} == "-alt" && ++i < argc )
+                landmark_count = std::stoi(argv[i]);
+        if( osm_data_file.empty() )
+            osm_data_file = "../map.osm";
     }
     else {
         std::cout << "To specify a map file use the following format: " << std::endl;
-        std::cout << "Usage: [executable] [-f filename.osm]" << std::endl;
+        std::cout << "Usage: [executable] [-f filename.osm] [-ch hierarchy.ch] [-fastest] [-foot] [-turns] [-left-turn cost] [-isochrone meters] [-alt landmarks] [-stats] [-trace trace.bin]" << std::endl;
+        std::cout << "Batch mode: [executable] [-f filename.osm] -batch queries.txt|- [-o results] [-binary] [-threads n] [-cache mb] [-stats]" << std::endl;
+        std::cout << "Server mode: [executable] [-f filename.osm] [-ch hierarchy.ch] -serve unix:/path|tcp:port [-threads n] [-cache mb]" << std::endl;
         osm_data_file = "../map.osm";
     }
     
     std::vector<std::byte> osm_data;
  
     if( osm_data.empty() && !osm_data_file.empty() ) {
-        std::cout << "Reading OpenStreetMap data from the following file: " <<  osm_data_file << std::endl;
+        // Keep stdout clean for the results in batch mode; the server logs there too.
+        std::ostream &log = batch_file.empty() && serve_address.empty() ? std::cout : std::cerr;
+        log << "Reading OpenStreetMap data from the following file: " <<  osm_data_file << std::endl;
         auto data = ReadFile(osm_data_file);
         if( !data )
-            std::cout << "Failed to read." << std::endl;
+            log << "Failed to read." << std::endl;
         else
             osm_data = std::move(*data);
     }
 
+    if( !serve_address.empty() )
+        return RunServer(osm_data, osm_data_file, serve_address, ch_file, thread_count, cache_mb);
+    if( !batch_file.empty() )
+        return RunBatch(osm_data, batch_file, ch_file, output_file, binary_output, thread_count, cache_mb, show_stats);
+
+    // Build the model in the background while the endpoints are typed in, together with
+    // everything the first search would otherwise build on demand.
+    using Clock = std::chrono::steady_clock;
+    struct LoadedMap {
+        std::unique_ptr<RouteModel> model;
+        std::optional<ContractionHierarchy> hierarchy;
+        std::optional<Landmarks> landmarks;
+        Clock::time_point ready;
+    };
+    std::shared_future<LoadedMap> loading = std::async(std::launch::async, [&] {
+        LoadedMap map;
+        map.model = std::make_unique<RouteModel>(osm_data);
+        // Load the contraction hierarchy if one was requested, building and saving it when needed.
+        if( !ch_file.empty() )
+            map.hierarchy = LoadOrBuildHierarchy(map.model->Graph(), ch_file);
+        const auto profile = foot ? RouteGraph::Profile::Foot : RouteGraph::Profile::Car;
+        map.model->Graph(profile);
+        if( turns )
+            map.model->Turns(profile);
+        // Landmark tables only bound distances on the graph they were built on.
+        if( landmark_count > 0 )
+            map.landmarks.emplace(map.model->Graph(profile), landmark_count);
+        map.ready = Clock::now();
+        return map;
+    });
+
+    // Snap each endpoint as soon as both the map and its coordinates are there, the start one
+    // while the end one is still typed in. Walks keep to the main network, as footpaths often
+    // end in fragments of their own. Only the snapping itself is timed, not waiting for the map.
+    auto snap = [&loading, foot](float x, float y, double &snap_us) {
+        const auto profile = foot ? RouteGraph::Profile::Foot : RouteGraph::Profile::Car;
+        RouteModel &model = *loading.get().model;
+        SearchTimer timer(snap_us);
+        return &model.FindClosestNode(x * 0.01f, y * 0.01f, foot, profile);
+    };
     float start_x, start_y, end_x, end_y;
-    bool is_percent = false;
-    while (!is_percent){
-      std::cout << "Enter start_x (percent): ";
-      std::cin >> start_x;
-      std::cout << "Enter start_y (percent): ";
-      std::cin >> start_y;
-      std::cout << "Enter end_x (percent): ";
-      std::cin >> end_x;
-      std::cout << "Enter end_y (percent): ";
-      std::cin >> end_y;
-      is_percent = (verify_percent(start_x) && verify_percent(start_y) && verify_percent(end_x) &&
-                    verify_percent(end_y));
-      if (!is_percent){
-        std::cout << "Try again. All numbers must be between 0 and 100\n";
-      }
-    }
+    double start_snap_us = 0.0;
+    double end_snap_us = 0.0;
+    ReadPoint("start", start_x, start_y);
+    auto snapping_start = std::async(std::launch::async, snap, start_x, start_y, std::ref(start_snap_us));
+    ReadPoint("end", end_x, end_y);
+    const auto entered = Clock::now();
+    RouteModel::Node &end_node = *snap(end_x, end_y, end_snap_us);
+    RouteModel::Node &start_node = *snapping_start.get();
+    const double snap_us = start_snap_us + end_snap_us;
 
-    // Build Model.
-    RouteModel model{osm_data};
+    const LoadedMap &map = loading.get();
+    RouteModel &model = *map.model;
+    const std::optional<ContractionHierarchy> &hierarchy = map.hierarchy;
+    if( hierarchy && foot )
+        std::cerr << "The contraction hierarchy is built for cars; ignoring it for walking routes." << std::endl;
+    if( hierarchy && fastest )
+        std::cerr << "The contraction hierarchy is built on distances; ignoring it for fastest routes." << std::endl;
+    if( hierarchy && turns )
+        std::cerr << "The contraction hierarchy has no turn restrictions; ignoring it for turn-aware routes." << std::endl;
+    if( hierarchy && map.landmarks && !foot && !fastest && !turns )
+        std::cerr << "The contraction hierarchy answers the queries; the landmarks are not used." << std::endl;
+
+    // Record the settled nodes of every search, to save and draw the last one.
+    SearchTrace trace;
+    auto search = [&](auto &planner) {
+        if( turns )
+            planner.TurnAwareSearch();
+        else if( fastest || foot )
+            planner.GraphAStarSearch();
+        else if( hierarchy )
+            planner.ContractionHierarchySearch(*hierarchy);
+        else
+            planner.AStarSearch();
+        std::cout << "Distance: " << planner.GetDistance() << " meters. \n";
+        if( fastest )
+            std::cout << "Travel time: " << planner.GetCost() / 60.f << " minutes. \n";
+        if( show_stats ) {
+            const SearchStats &stats = planner.Stats();
+            std::cout << "Settled " << stats.settled_nodes << " nodes, relaxed " << stats.relaxed_edges << " edges, "
+                      << stats.heap_pushes << " pushes, " << stats.heap_pops << " pops, open list peak "
+                      << stats.max_open_list << ", snapping " << stats.snap_us << " us, search "
+                      << stats.search_us << " us. \n";
+        }
+    };
+    auto plan = [&](auto &route_planner) {
+        route_planner.SetTurnCosts(turn_costs);
+        if( map.landmarks )
+            route_planner.SetLandmarks(&*map.landmarks);
+        if( !trace_file.empty() )
+            route_planner.SetTrace(&trace);
+        search(route_planner);
+        const auto milliseconds = [](Clock::duration duration) {
+            return std::chrono::duration<double, std::milli>(duration).count();
+        };
+        const auto waited = std::max(map.ready - entered, Clock::duration::zero());
+        std::cout << "Time to first route: " << milliseconds(Clock::now() - entered) << " ms after the endpoints were entered, "
+                  << milliseconds(waited) << " ms of it waiting for the map to load. \n";
+
+        // Answer further queries on the already loaded model; the planner resets in O(1).
+        while (AskYesNo("Plan another route? (y/n): ")) {
+          ReadEndpoints(start_x, start_y, end_x, end_y);
+          route_planner.SetEndpoints(start_x, start_y, end_x, end_y);
+          search(route_planner);
+        }
+    };
 
     // Create RoutePlanner object and perform A* search.
-    RoutePlanner route_planner{model, start_x, start_y, end_x, end_y};
-    route_planner.AStarSearch();
+    if( fastest && foot ) {
+        FastestRoutePlanner route_planner{model, start_node, end_node, snap_us, TravelTimeCost{RouteGraph::Profile::Foot},
+                                          RouteGraph::Profile::Foot};
+        route_planner.SetSnapToLargestComponent(true);
+        plan(route_planner);
+    }
+    else if( fastest ) {
+        FastestRoutePlanner route_planner{model, start_node, end_node, snap_us};
+        plan(route_planner);
+    }
+    else if( foot ) {
+        RoutePlanner route_planner{model, start_node, end_node, snap_us, DistanceCost{}, RouteGraph::Profile::Foot};
+        route_planner.SetSnapToLargestComponent(true);
+        plan(route_planner);
+    }
+    else {
+        RoutePlanner route_planner{model, start_node, end_node, snap_us};
+        plan(route_planner);
+    }
 
-    std::cout << "Distance: " << route_planner.GetDistance() << " meters. \n";
+    if( !trace_file.empty() && !trace.Save(trace_file, static_cast<int>(model.Nodes().size())) )
+        std::cerr << "Failed to write " << trace_file << std::endl;
 
     // Render results of search.
     Render render{model};
+    render.SetTrace(std::move(trace));
+    if( isochrone_m > 0.f ) {
+        const auto profile = foot ? RouteGraph::Profile::Foot : RouteGraph::Profile::Car;
+        int source = model.FindClosestNode(start_x * 0.01f, start_y * 0.01f, foot, profile).Index();
+        auto isochrone = model.FindIsochrone(source, isochrone_m, profile);
+        std::cout << isochrone.nodes.size() << " nodes within " << isochrone_m << " meters of the start. \n";
+        render.SetIsochrone(std::move(isochrone));
+    }
 
     auto display = io2d::output_surface{400, 400, io2d::format::argb32, io2d::scaling::none, io2d::refresh_style::fixed, 30};
     display.size_change_callback([](io2d::output_surface& surface){
@@ -37,6 +37,20 @@ static Model::Landuse::Type String2LanduseType(std::string_view type)
     return Model::Landuse::Invalid;
 }
 
+static Model::Road::Oneway String2Oneway(std::string_view type)
+{
+    if( type == "yes" || type == "true" || type == "1" )    return Model::Road::Forward;
+    if( type == "-1" || type == "reverse" )                 return Model::Road::Backward;
+    return Model::Road::No;
+}
+
+static Model::TurnRestriction::Type String2RestrictionType(std::string_view type)
+{
+    if( type.substr(0, 3) == "no_" )    return Model::TurnRestriction::No;
+    if( type.substr(0, 5) == "only_" )  return Model::TurnRestriction::Only;
+    return Model::TurnRestriction::Invalid;
+}
+
 Model::Model( const std::vector<std::byte> &xml )
 {
     LoadData(xml);
@@ -82,6 +96,10 @@ void Model::LoadData(const std::vector<std::byte> &xml)
         way_id_to_num[node.attribute("id").as_string()] = way_num;
         m_Ways.emplace_back();
         auto &new_way = m_Ways.back();
+        const auto road_count = m_Roads.size();
+        // Motorways and roundabouts are one-way unless tagged otherwise.
+        std::string_view oneway_tag;
+        bool implied_oneway = false;
         
         for( auto child: node.children() ) {
             auto name = std::string_view{child.name()}; 
@@ -93,6 +111,10 @@ void Model::LoadData(const std::vector<std::byte> &xml)
             else if( name == "tag" ) {
                 auto category = std::string_view{child.attribute("k").as_string()};
                 auto type = std::string_view{child.attribute("v").as_string()};
+                if( category == "oneway" )
+                    oneway_tag = type;
+                if( (category == "highway" && type == "motorway") || (category == "junction" && type == "roundabout") )
+                    implied_oneway = true;
                 if( category == "highway" ) {
                     if( auto road_type = String2RoadType(type); road_type != Road::Invalid ) {
                         m_Roads.emplace_back();
@@ -127,6 +149,12 @@ void Model::LoadData(const std::vector<std::byte> &xml)
                 }
             }
         }
+        if( m_Roads.size() > road_count ) {
+            if( !oneway_tag.empty() )
+                m_Roads.back().oneway = String2Oneway(oneway_tag);
+            else if( implied_oneway )
+                m_Roads.back().oneway = Road::Forward;
+        }
     }
     
     for( const auto &relation: doc.select_nodes("/osm/relation") ) {
@@ -137,22 +165,38 @@ void Model::LoadData(const std::vector<std::byte> &xml)
             mp.outer = std::move(outer);
             mp.inner = std::move(inner);
         };
+        // Only restrictions via a single node are kept, restrictions via ways are rare.
+        TurnRestriction restriction{-1, -1, -1, TurnRestriction::Invalid};
+        bool is_restriction = false;
         for( auto child: node.children() ) {
             auto name = std::string_view{child.name()}; 
             if( name == "member" ) {
+                auto role = std::string_view{child.attribute("role").as_string()};
                 if( std::string_view{child.attribute("type").as_string()} == "way" ) {
                     if( !way_id_to_num.count(child.attribute("ref").as_string()) )
                         continue;
                     auto way_num = way_id_to_num[child.attribute("ref").as_string()];
-                    if( std::string_view{child.attribute("role").as_string()} == "outer" )
+                    if( role == "from" )
+                        restriction.from = way_num;
+                    else if( role == "to" )
+                        restriction.to = way_num;
+                    if( role == "outer" )
                         outer.emplace_back(way_num);
                     else
                         inner.emplace_back(way_num);
                 }
+                else if( std::string_view{child.attribute("type").as_string()} == "node" && role == "via" ) {
+                    if( auto it = node_id_to_num.find(child.attribute("ref").as_string()); it != end(node_id_to_num) )
+                        restriction.via = it->second;
+                }
             }
             else if( name == "tag" ) { 
                 auto category = std::string_view{child.attribute("k").as_string()};
                 auto type = std::string_view{child.attribute("v").as_string()};
+                if( category == "type" && type == "restriction" )
+                    is_restriction = true;
+                if( category == "restriction" )
+                    restriction.type = String2RestrictionType(type);
                 if( category == "building" ) {
                     commit( m_Buildings.emplace_back() );
                     break;
@@ -172,6 +216,9 @@ void Model::LoadData(const std::vector<std::byte> &xml)
                 }
             }
         }
+        if( is_restriction && restriction.type != TurnRestriction::Invalid &&
+            restriction.from != -1 && restriction.via != -1 && restriction.to != -1 )
+            m_TurnRestrictions.emplace_back(restriction);
     }
 }
 
@@ -20,8 +20,11 @@ public:
     struct Road {
         enum Type { Invalid, Unclassified, Service, Residential,
             Tertiary, Secondary, Primary, Trunk, Motorway, Footway };
+        // Direction of travel allowed relative to the order of the way's nodes.
+        enum Oneway { No, Forward, Backward };
         int way;
         Type type;
+        Oneway oneway = No;
     };
     
     struct Railway {
@@ -44,6 +47,15 @@ public:
         Type type;
     };
     
+    // Turn from one way onto another at a node, from a type=restriction relation.
+    struct TurnRestriction {
+        enum Type { Invalid, No, Only };
+        int from;
+        int via;
+        int to;
+        Type type;
+    };
+    
     Model( const std::vector<std::byte> &xml );
     
     auto MetricScale() const noexcept { return m_MetricScale; }    
@@ -56,6 +68,7 @@ public:
     auto &Waters() const noexcept { return m_Waters; }
     auto &Landuses() const noexcept { return m_Landuses; }
     auto &Railways() const noexcept { return m_Railways; }
+    auto &TurnRestrictions() const noexcept { return m_TurnRestrictions; }
     
 private:
     void AdjustCoordinates();
@@ -70,6 +83,7 @@ private:
     std::vector<Leisure> m_Leisures;
     std::vector<Water> m_Waters;
     std::vector<Landuse> m_Landuses;
+    std::vector<TurnRestriction> m_TurnRestrictions;
     
     double m_MinLat = 0.;
     double m_MaxLat = 0.;
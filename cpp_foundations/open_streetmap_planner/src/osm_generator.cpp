@@ -0,0 +1,292 @@
+#include "osm_generator.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Random draws are hashes of the seed, a purpose and a position, so any part of the map can be
+// generated on its own and in any order.
+enum Draw : std::uint64_t { kJitterX = 1, kJitterY, kStreetType, kOneway, kDrop, kDiagonal, kBuilding, kMultipolygon, kArea };
+
+std::uint64_t Hash(std::uint64_t x) {
+    // splitmix64 finalizer
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+class Generator {
+  public:
+    Generator(std::ostream &os, const SyntheticCity &city) : os(os), city(city) {
+        const double cell_nodes = 1.0 + 2.0 * city.shape_points + 4.0 * city.building_density +
+                                  8.0 * city.multipolygon_density;
+        width = std::max<std::int64_t>(2, std::llround(std::sqrt(city.target_nodes / cell_nodes)));
+        height = width;
+        horizontal_edges = height * (width - 1);
+        const std::int64_t edges = horizontal_edges + (height - 1) * width;
+        const std::int64_t cells = (height - 1) * (width - 1);
+        shape_first = 1 + width * height;
+        building_first = shape_first + edges * city.shape_points;
+        multipolygon_first = building_first + 4 * cells;
+
+        constexpr double kPi = 3.14159265358979323846;
+        lat_step = city.block_meters / kMetersPerDegree;
+        lon_step = city.block_meters / (kMetersPerDegree * std::cos(kOriginLat * kPi / 180.0));
+    }
+
+    std::int64_t Write() {
+        os << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+        os << "<osm version=\"0.6\" generator=\"osm_generator\">\n";
+        os << std::fixed << std::setprecision(7);
+        // One block of margin around the streets.
+        os << " <bounds minlat=\"" << Lat(-1.0) << "\" minlon=\"" << Lon(-1.0) << "\" maxlat=\"" << Lat(height)
+           << "\" maxlon=\"" << Lon(width) << "\"/>\n";
+        WriteNodes();
+        WriteStreets();
+        WriteAreas();
+        os << "</osm>\n";
+        return node_count;
+    }
+
+  private:
+    enum class Cell { Empty, Diagonal, Building, Multipolygon };
+    struct Point {
+        double x, y;  // In blocks.
+    };
+
+    static constexpr double kOriginLat = 30.0;
+    static constexpr double kOriginLon = -97.0;
+    static constexpr double kMetersPerDegree = 111320.0;
+
+    double Uniform(Draw draw, std::int64_t a, std::int64_t b = 0) const {
+        const std::uint64_t h = Hash(city.seed ^ Hash(draw ^ Hash(static_cast<std::uint64_t>(a) ^ Hash(b))));
+        return (h >> 11) * (1.0 / 9007199254740992.0);
+    }
+    bool Planar() const { return city.layout == SyntheticCity::Layout::RandomPlanar; }
+    double Lat(double y) const { return kOriginLat + y * lat_step; }
+    double Lon(double x) const { return kOriginLon + x * lon_step; }
+
+    std::int64_t Intersection(std::int64_t r, std::int64_t c) const { return 1 + r * width + c; }
+    Point Position(std::int64_t r, std::int64_t c) const {
+        if (!Planar()) {
+            return {static_cast<double>(c), static_cast<double>(r)};
+        }
+        // Small enough jitter that every block stays convex around its building.
+        return {c + 0.3 * (Uniform(kJitterX, r, c) - 0.5), r + 0.3 * (Uniform(kJitterY, r, c) - 0.5)};
+    }
+    // Edges from (r, c) to (r, c + 1) come first, then those from (r, c) to (r + 1, c).
+    std::int64_t ShapePoint(bool vertical, std::int64_t r, std::int64_t c, int k) const {
+        const std::int64_t edge = vertical ? horizontal_edges + r * width + c : r * (width - 1) + c;
+        return shape_first + edge * city.shape_points + k;
+    }
+
+    Cell CellKind(std::int64_t r, std::int64_t c) const {
+        if (Planar() && Uniform(kDiagonal, r, c) < city.diagonal_fraction) {
+            return Cell::Diagonal;
+        }
+        if (Uniform(kBuilding, r, c) < city.building_density) {
+            return Cell::Building;
+        }
+        if (Uniform(kMultipolygon, r, c) < city.multipolygon_density) {
+            return Cell::Multipolygon;
+        }
+        return Cell::Empty;
+    }
+    Point Center(std::int64_t r, std::int64_t c) const {
+        Point a = Position(r, c), b = Position(r, c + 1), d = Position(r + 1, c), e = Position(r + 1, c + 1);
+        return {(a.x + b.x + d.x + e.x) / 4, (a.y + b.y + d.y + e.y) / 4};
+    }
+
+    void Node(std::int64_t id, Point p) {
+        os << " <node id=\"" << id << "\" version=\"1\" lat=\"" << Lat(p.y) << "\" lon=\"" << Lon(p.x) << "\"/>\n";
+        node_count++;
+    }
+    // Corners of a square around a point, counterclockwise from the bottom left.
+    void Square(std::int64_t first_id, Point center, double half) {
+        Node(first_id, {center.x - half, center.y - half});
+        Node(first_id + 1, {center.x + half, center.y - half});
+        Node(first_id + 2, {center.x + half, center.y + half});
+        Node(first_id + 3, {center.x - half, center.y + half});
+    }
+
+    void WriteNodes() {
+        for (std::int64_t r = 0; r < height; ++r) {
+            for (std::int64_t c = 0; c < width; ++c) {
+                Node(Intersection(r, c), Position(r, c));
+            }
+        }
+        for (bool vertical : {false, true}) {
+            for (std::int64_t r = 0; r < height - vertical; ++r) {
+                for (std::int64_t c = 0; c < width - !vertical; ++c) {
+                    const Point from = Position(r, c);
+                    const Point to = vertical ? Position(r + 1, c) : Position(r, c + 1);
+                    for (int k = 0; k < city.shape_points; ++k) {
+                        const double t = (k + 1.0) / (city.shape_points + 1.0);
+                        Node(ShapePoint(vertical, r, c, k), {from.x + t * (to.x - from.x), from.y + t * (to.y - from.y)});
+                    }
+                }
+            }
+        }
+        for (std::int64_t r = 0; r + 1 < height; ++r) {
+            for (std::int64_t c = 0; c + 1 < width; ++c) {
+                const std::int64_t cell = r * (width - 1) + c;
+                const Cell kind = CellKind(r, c);
+                if (kind == Cell::Building) {
+                    Square(building_first + 4 * cell, Center(r, c), 0.15);
+                }
+                else if (kind == Cell::Multipolygon) {
+                    Square(multipolygon_first + 8 * cell, Center(r, c), 0.18);
+                    Square(multipolygon_first + 8 * cell + 4, Center(r, c), 0.08);
+                }
+            }
+        }
+    }
+
+    // Street type of the line-th horizontal or vertical street.
+    std::string StreetType(bool vertical, std::int64_t line) const {
+        if (line % 16 == 0) {
+            return "primary";
+        }
+        if (line % 4 == 0) {
+            return "secondary";
+        }
+        static const char *const kLocalTypes[] = {"residential", "service", "unclassified", "footway"};
+        const double total = city.residential + city.service + city.unclassified + city.footway;
+        double pick = Uniform(kStreetType, vertical, line) * total;
+        const double weights[] = {city.residential, city.service, city.unclassified, city.footway};
+        for (int i = 0; i < 3; ++i) {
+            if (pick < weights[i]) {
+                return kLocalTypes[i];
+            }
+            pick -= weights[i];
+        }
+        return kLocalTypes[3];
+    }
+
+    void Way(const std::vector<std::int64_t> &nodes, const std::vector<std::pair<const char *, std::string>> &tags) {
+        os << " <way id=\"" << ++way_count << "\" version=\"1\">\n";
+        for (std::int64_t node : nodes) {
+            os << "  <nd ref=\"" << node << "\"/>\n";
+        }
+        for (const auto &[key, value] : tags) {
+            os << "  <tag k=\"" << key << "\" v=\"" << value << "\"/>\n";
+        }
+        os << " </way>\n";
+    }
+
+    void WriteStreets() {
+        std::vector<std::int64_t> nodes;
+        for (bool vertical : {false, true}) {
+            const std::int64_t lines = vertical ? width : height;
+            const std::int64_t blocks = (vertical ? height : width) - 1;
+            for (std::int64_t line = 0; line < lines; ++line) {
+                const std::string type = StreetType(vertical, line);
+                const bool local = line % 4 != 0;
+                std::vector<std::pair<const char *, std::string>> tags{{"highway", type}};
+                if (local && type != "footway" && Uniform(kOneway, vertical, line) < city.oneway_fraction) {
+                    tags.emplace_back("oneway", line % 2 ? "yes" : "-1");
+                }
+                auto flush = [&] {
+                    if (nodes.size() > 1) {
+                        Way(nodes, tags);
+                    }
+                    nodes.clear();
+                };
+                for (std::int64_t b = 0; b < blocks; ++b) {
+                    const std::int64_t r = vertical ? b : line;
+                    const std::int64_t c = vertical ? line : b;
+                    if (Planar() && local && Uniform(kDrop, vertical ? -1 - r : r, c) < city.drop_fraction) {
+                        flush();
+                        continue;
+                    }
+                    if (nodes.empty()) {
+                        nodes.push_back(Intersection(r, c));
+                    }
+                    for (int k = 0; k < city.shape_points; ++k) {
+                        nodes.push_back(ShapePoint(vertical, r, c, k));
+                    }
+                    nodes.push_back(vertical ? Intersection(r + 1, c) : Intersection(r, c + 1));
+                    if (static_cast<int>(nodes.size() - 1) >= city.blocks_per_way * (city.shape_points + 1)) {
+                        const std::int64_t last = nodes.back();
+                        flush();
+                        nodes.push_back(last);
+                    }
+                }
+                flush();
+            }
+        }
+    }
+
+    void WriteAreas() {
+        // Ways of the multipolygons in block order, so the relations can refer to them by count.
+        std::int64_t multipolygons = 0;
+        std::int64_t multipolygon_way_first = 0;
+        for (int pass = 0; pass < 2; ++pass) {
+            for (std::int64_t r = 0; r + 1 < height; ++r) {
+                for (std::int64_t c = 0; c + 1 < width; ++c) {
+                    const std::int64_t cell = r * (width - 1) + c;
+                    const Cell kind = CellKind(r, c);
+                    if (pass == 0 && kind == Cell::Diagonal) {
+                        const bool rising = Uniform(kDiagonal, c, r) < 0.5;
+                        Way({Intersection(r, rising ? c : c + 1), Intersection(r + 1, rising ? c + 1 : c)},
+                            {{"highway", "residential"}});
+                    }
+                    else if (pass == 0 && kind == Cell::Building) {
+                        const std::int64_t first = building_first + 4 * cell;
+                        Way({first, first + 1, first + 2, first + 3, first}, {{"building", "yes"}});
+                    }
+                    else if (pass == 1 && kind == Cell::Multipolygon) {
+                        if (multipolygons == 0) {
+                            multipolygon_way_first = way_count + 1;
+                        }
+                        multipolygons++;
+                        // The outer ring is split in two ways that have to be joined into a ring.
+                        const std::int64_t outer = multipolygon_first + 8 * cell;
+                        const std::int64_t inner = outer + 4;
+                        Way({outer, outer + 1, outer + 2}, {});
+                        Way({outer + 2, outer + 3, outer}, {});
+                        Way({inner, inner + 1, inner + 2, inner + 3, inner}, {});
+                    }
+                }
+            }
+        }
+
+        static const char *const kAreas[][2] = {{"building", "yes"}, {"landuse", "grass"}, {"natural", "water"}};
+        std::int64_t relation = 0;
+        for (std::int64_t r = 0; r + 1 < height; ++r) {
+            for (std::int64_t c = 0; c + 1 < width; ++c) {
+                if (CellKind(r, c) != Cell::Multipolygon) {
+                    continue;
+                }
+                const std::int64_t ways = multipolygon_way_first + 3 * relation;
+                const auto &area = kAreas[static_cast<int>(Uniform(kArea, r, c) * 3)];
+                os << " <relation id=\"" << ++relation << "\" version=\"1\">\n";
+                os << "  <member type=\"way\" ref=\"" << ways << "\" role=\"outer\"/>\n";
+                os << "  <member type=\"way\" ref=\"" << ways + 1 << "\" role=\"outer\"/>\n";
+                os << "  <member type=\"way\" ref=\"" << ways + 2 << "\" role=\"inner\"/>\n";
+                os << "  <tag k=\"type\" v=\"multipolygon\"/>\n";
+                os << "  <tag k=\"" << area[0] << "\" v=\"" << area[1] << "\"/>\n";
+                os << " </relation>\n";
+            }
+        }
+    }
+
+    std::ostream &os;
+    const SyntheticCity &city;
+    std::int64_t width, height;  // Intersections per street and streets.
+    std::int64_t horizontal_edges;
+    std::int64_t shape_first, building_first, multipolygon_first;  // First node id of each kind.
+    double lat_step, lon_step;  // Degrees per block.
+    std::int64_t node_count = 0;
+    std::int64_t way_count = 0;
+};
+
+}  // namespace
+
+std::int64_t WriteSyntheticCity(std::ostream &os, const SyntheticCity &city) {
+    return Generator{os, city}.Write();
+}
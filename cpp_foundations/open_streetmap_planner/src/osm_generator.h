@@ -0,0 +1,48 @@
+#ifndef OSM_GENERATOR_H
+#define OSM_GENERATOR_H
+
+#include <cstdint>
+#include <iostream>
+
+// Parameters of a synthetic city for scaling tests. Streets form a grid of square blocks, every
+// fourth street is secondary and every sixteenth primary, the others are local streets of a
+// weighted mix of types. The same parameters and seed always give the same map.
+struct SyntheticCity {
+    enum class Layout {
+        Grid,
+        // A grid with jittered intersections, some local street blocks left out and some blocks
+        // cut by a diagonal street. Streets still only meet at intersections.
+        RandomPlanar,
+    };
+
+    Layout layout = Layout::Grid;
+    // Approximate number of nodes of the map, from about 10^3 to 10^8.
+    std::int64_t target_nodes = 10000;
+    double block_meters = 100.0;
+    // Nodes on every street between two intersections.
+    int shape_points = 1;
+    // Blocks covered by one way, as long streets are split into several ways in OSM too.
+    int blocks_per_way = 8;
+    // Relative weights of the local street types.
+    double residential = 0.7;
+    double service = 0.15;
+    double unclassified = 0.1;
+    double footway = 0.05;
+    // Fraction of the local streets that are one-way.
+    double oneway_fraction = 0.1;
+    // Fraction of the blocks with a building, and of the others with a multipolygon relation of
+    // an outer ring in two ways around an inner ring: a building with a courtyard, a park with a
+    // pond or a lake with an island.
+    double building_density = 0.3;
+    double multipolygon_density = 0.05;
+    // RandomPlanar only: fraction of local street blocks left out and of blocks with a diagonal.
+    double drop_fraction = 0.1;
+    double diagonal_fraction = 0.1;
+    std::uint64_t seed = 1;
+};
+
+// Writes the city as OSM XML, streaming it without holding the map in memory. Returns the
+// number of nodes written.
+std::int64_t WriteSyntheticCity(std::ostream &os, const SyntheticCity &city);
+
+#endif
@@ -0,0 +1,58 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "osm_generator.h"
+
+// Writes a synthetic city as OSM XML, for tests and benchmarks on maps of any size.
+int main(int argc, const char **argv)
+{
+    SyntheticCity city;
+    std::string output_file = "";
+    for( int i = 1; i < argc; ++i ) {
+        const std::string_view arg{argv[i]};
+        if( arg == "-nodes" && ++i < argc )
+            city.target_nodes = std::stoll(argv[i]);
+        else if( arg == "-layout" && ++i < argc )
+            city.layout = std::string_view{argv[i]} == "planar" ? SyntheticCity::Layout::RandomPlanar
+                                                                 : SyntheticCity::Layout::Grid;
+        else if( arg == "-block" && ++i < argc )
+            city.block_meters = std::stod(argv[i]);
+        else if( arg == "-shape-points" && ++i < argc )
+            city.shape_points = std::stoi(argv[i]);
+        else if( arg == "-mix" && ++i < argc ) {
+            // Weights of residential, service, unclassified and footway local streets.
+            std::istringstream weights{argv[i]};
+            char comma;
+            if( !(weights >> city.residential >> comma >> city.service >> comma >> city.unclassified >> comma >> city.footway) ) {
+                std::cerr << "Expected four comma separated weights after -mix" << std::endl;
+                return 1;
+            }
+        }
+        else if( arg == "-oneway" && ++i < argc )
+            city.oneway_fraction = std::stod(argv[i]);
+        else if( arg == "-buildings" && ++i < argc )
+            city.building_density = std::stod(argv[i]);
+        else if( arg == "-multipolygons" && ++i < argc )
+            city.multipolygon_density = std::stod(argv[i]);
+        else if( arg == "-seed" && ++i < argc )
+            city.seed = std::stoull(argv[i]);
+        else if( arg == "-o" && ++i < argc )
+            output_file = argv[i];
+        else {
+            std::cerr << "Usage: osm_generator [-nodes n] [-layout grid|planar] [-block meters] [-shape-points n]"
+                      << " [-mix residential,service,unclassified,footway] [-oneway fraction] [-buildings fraction]"
+                      << " [-multipolygons fraction] [-seed n] [-o file.osm]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::ofstream file;
+    if( !output_file.empty() )
+        file.open(output_file);
+    std::ostream &os = output_file.empty() ? std::cout : file;
+    const auto nodes = WriteSyntheticCity(os, city);
+    std::cerr << "Wrote " << nodes << " nodes." << std::endl;
+    return os ? 0 : 1;
+}
@@ -0,0 +1,208 @@
+#include "overlay.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace {
+
+using Queue = std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>,
+                                  std::greater<std::pair<float, int>>>;
+
+// Dijkstra from source that asks relax(u, distance, reach) for the edges of every settled node,
+// until stop(u) returns true for a settled node.
+template <typename Relax, typename Stop>
+int Dijkstra(int source, SearchSpace &space, Relax relax, Stop stop) {
+    space.Clear();
+    Queue queue;
+    space.Reach(source, 0.0f, -1);
+    queue.emplace(0.0f, source);
+    int settled = 0;
+    while (!queue.empty()) {
+        auto [distance, u] = queue.top();
+        queue.pop();
+        if (space.Settled(u)) {
+            continue;
+        }
+        space.Settle(u);
+        ++settled;
+        if (stop(u)) {
+            break;
+        }
+        relax(u, distance, [&](int v, float candidate, int parent) {
+            if (candidate < space.Distance(v)) {
+                space.Reach(v, candidate, parent);
+                queue.emplace(candidate, v);
+            }
+        });
+    }
+    return settled;
+}
+
+}  // namespace
+
+Overlay::Overlay(const RouteGraph &graph, const Partition &partition, int thread_count) :
+    m_Graph(graph), m_Partition(partition), m_Levels(partition.LevelCount()), m_Pool(thread_count),
+    m_Spaces(m_Pool.Size(), SearchSpace{graph.NodeCount()}) {
+    const auto &forward = graph.Forward();
+    const auto &backward = graph.Backward();
+    for (int l = 0; l < partition.LevelCount(); ++l) {
+        Level &level = m_Levels[l];
+        auto crosses = [&](int v, const RouteGraph::Adjacency &edges) {
+            for (int e = edges.Begin(v); e < edges.End(v); ++e) {
+                if (partition.Cell(l, edges.head[e]) != partition.Cell(l, v)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        std::vector<std::vector<int>> boundary(partition.CellCount(l));
+        level.boundary_index.assign(graph.NodeCount(), -1);
+        for (int v = 0; v < graph.NodeCount(); ++v) {
+            if (partition.Cell(l, v) != -1 && (crosses(v, forward) || crosses(v, backward))) {
+                auto &cell_boundary = boundary[partition.Cell(l, v)];
+                level.boundary_index[v] = static_cast<int>(cell_boundary.size());
+                cell_boundary.push_back(v);
+            }
+        }
+
+        level.boundary_first.push_back(0);
+        level.matrix_first.push_back(0);
+        for (const auto &cell_boundary : boundary) {
+            level.boundary.insert(level.boundary.end(), cell_boundary.begin(), cell_boundary.end());
+            level.boundary_first.push_back(static_cast<int>(level.boundary.size()));
+            level.matrix_first.push_back(level.matrix_first.back() + cell_boundary.size() * cell_boundary.size());
+        }
+        level.matrix.resize(level.matrix_first.back());
+    }
+    Customize(forward.weight);
+}
+
+void Overlay::Customize(const std::vector<float> &weights) {
+    m_Weights = weights;
+    // Cells of a level are independent; each level needs the one below it to be finished.
+    for (int l = 0; l < m_Partition.LevelCount(); ++l) {
+        m_Pool.ParallelFor(m_Partition.CellCount(l), [&](int cell, int worker) {
+            CustomizeCell(l, cell, m_Spaces[worker]);
+        });
+    }
+}
+
+void Overlay::CustomizeCell(int l, int cell, SearchSpace &space) {
+    Level &level = m_Levels[l];
+    const auto &forward = m_Graph.Forward();
+    const int size = level.BoundarySize(cell);
+    const int *boundary = level.boundary.data() + level.boundary_first[cell];
+
+    // On the finest level search the original edges of the cell. Above it, search the boundary
+    // nodes of the subcells, joined by their matrices and by the edges between subcells.
+    auto relax = [&](int u, float distance, auto reach) {
+        if (l > 0) {
+            const Level &below = m_Levels[l - 1];
+            const int subcell = m_Partition.Cell(l - 1, u);
+            const int sub_size = below.BoundarySize(subcell);
+            const float *row = below.matrix.data() + below.matrix_first[subcell] + below.boundary_index[u] * sub_size;
+            const int *sub_boundary = below.boundary.data() + below.boundary_first[subcell];
+            for (int j = 0; j < sub_size; ++j) {
+                reach(sub_boundary[j], distance + row[j], u);
+            }
+        }
+        for (int e = forward.Begin(u); e < forward.End(u); ++e) {
+            int v = forward.head[e];
+            bool inside = m_Partition.Cell(l, v) == cell;
+            bool leaves_subcell = l == 0 || m_Partition.Cell(l - 1, v) != m_Partition.Cell(l - 1, u);
+            if (inside && leaves_subcell) {
+                reach(v, distance + m_Weights[e], u);
+            }
+        }
+    };
+
+    float *matrix = level.matrix.data() + level.matrix_first[cell];
+    for (int i = 0; i < size; ++i) {
+        Dijkstra(boundary[i], space, relax, [](int) { return false; });
+        for (int j = 0; j < size; ++j) {
+            matrix[i * size + j] = space.Distance(boundary[j]);
+        }
+    }
+}
+
+Overlay::QueryResult Overlay::Query(int source, int target, SearchSpace &space) const {
+    const auto &forward = m_Graph.Forward();
+    // Highest level on which v is in neither the source's nor the target's cell, or -1. Cells
+    // nest, so v is outside those cells on every level below it as well.
+    auto query_level = [&](int v) {
+        for (int l = m_Partition.LevelCount() - 1; l >= 0; --l) {
+            int cell = m_Partition.Cell(l, v);
+            if (cell != m_Partition.Cell(l, source) && cell != m_Partition.Cell(l, target)) {
+                return l;
+            }
+        }
+        return -1;
+    };
+
+    auto relax = [&](int u, float distance, auto reach) {
+        const int l = query_level(u);
+        if (l >= 0) {
+            const Level &level = m_Levels[l];
+            const int cell = m_Partition.Cell(l, u);
+            const int size = level.BoundarySize(cell);
+            const float *row = level.matrix.data() + level.matrix_first[cell] + level.boundary_index[u] * size;
+            const int *boundary = level.boundary.data() + level.boundary_first[cell];
+            for (int j = 0; j < size; ++j) {
+                reach(boundary[j], distance + row[j], u);
+            }
+        }
+        for (int e = forward.Begin(u); e < forward.End(u); ++e) {
+            int v = forward.head[e];
+            if (l < 0 || m_Partition.Cell(l, v) != m_Partition.Cell(l, u)) {
+                reach(v, distance + m_Weights[e], u);
+            }
+        }
+    };
+
+    QueryResult result;
+    result.settled_nodes = Dijkstra(source, space, relax, [&](int u) { return u == target; });
+    result.distance = space.Distance(target);
+    if (!space.Settled(target) || result.distance == std::numeric_limits<float>::infinity()) {
+        result.distance = std::numeric_limits<float>::infinity();
+        return result;
+    }
+
+    std::vector<int> overlay_path;
+    for (int v = target; v != -1; v = space.Parent(v)) {
+        overlay_path.push_back(v);
+    }
+    std::reverse(overlay_path.begin(), overlay_path.end());
+    result.path.push_back(source);
+    for (std::size_t i = 1; i < overlay_path.size(); ++i) {
+        int u = overlay_path[i - 1];
+        int v = overlay_path[i];
+        int l = query_level(u);
+        // Steps inside one cell of u's query level came from its matrix.
+        if (l >= 0 && m_Partition.Cell(l, v) == m_Partition.Cell(l, u)) {
+            UnpackCell(l, u, v, space, result.path);
+        } else {
+            result.path.push_back(v);
+        }
+    }
+    return result;
+}
+
+void Overlay::UnpackCell(int l, int from, int to, SearchSpace &space, std::vector<int> &path) const {
+    const auto &forward = m_Graph.Forward();
+    const int cell = m_Partition.Cell(l, from);
+    Dijkstra(from, space, [&](int u, float distance, auto reach) {
+        for (int e = forward.Begin(u); e < forward.End(u); ++e) {
+            if (m_Partition.Cell(l, forward.head[e]) == cell) {
+                reach(forward.head[e], distance + m_Weights[e], u);
+            }
+        }
+    }, [&](int u) { return u == to; });
+
+    const auto begin = path.size();
+    for (int v = to; v != from; v = space.Parent(v)) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin() + begin, path.end());
+}
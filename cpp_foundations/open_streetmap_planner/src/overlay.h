@@ -0,0 +1,61 @@
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <vector>
+#include "partition.h"
+#include "route_graph.h"
+#include "search_space.h"
+#include "thread_pool.h"
+
+// Customizable route planning (CRP) overlay on a multi-level Partition. For every cell it keeps
+// the shortest distances inside the cell between the cell's boundary nodes, i.e. the nodes with
+// an edge leaving or entering it. The partition and boundaries depend only on the topology;
+// Customize() recomputes the distance matrices for new edge weights, cell by cell in parallel
+// and level by level, each level from the matrices of the one below.
+class Overlay {
+  public:
+    struct QueryResult {
+        float distance = 0.0f;  // Infinity if there is no route.
+        int settled_nodes = 0;
+        std::vector<int> path;  // Node indices from source to target, empty without a route.
+    };
+
+    // Set up the boundaries and customize for the edge lengths of the graph.
+    Overlay(const RouteGraph &graph, const Partition &partition, int thread_count = 0);
+
+    // Switch to new weights, one per Forward() edge of the graph, e.g. RouteGraph::TravelTimes()
+    // or lengths with closed roads set to infinity.
+    void Customize(const std::vector<float> &weights);
+    const std::vector<float> &Weights() const { return m_Weights; }
+
+    // Dijkstra on the original edges near the source and target and on cell matrices of the
+    // coarsest possible level everywhere else. Uses only the given search space, so
+    // concurrent queries with separate search spaces are safe.
+    QueryResult Query(int source, int target, SearchSpace &space) const;
+    // Number of boundary nodes on a level, summed over its cells.
+    int BoundaryNodeCount(int level) const { return static_cast<int>(m_Levels[level].boundary.size()); }
+
+  private:
+    struct Level {
+        std::vector<int> boundary_first;  // Boundary nodes of cell c: [boundary_first[c], boundary_first[c + 1]).
+        std::vector<int> boundary;
+        std::vector<int> boundary_index;  // Position of a node in its cell's boundary list, or -1.
+        std::vector<std::size_t> matrix_first;  // Row major distance matrix of every cell.
+        std::vector<float> matrix;
+
+        int BoundarySize(int cell) const { return boundary_first[cell + 1] - boundary_first[cell]; }
+    };
+
+    void CustomizeCell(int level, int cell, SearchSpace &space);
+    // Shortest path within one cell of a level using original edges only, appended without from.
+    void UnpackCell(int level, int from, int to, SearchSpace &space, std::vector<int> &path) const;
+
+    const RouteGraph &m_Graph;
+    const Partition &m_Partition;
+    std::vector<Level> m_Levels;
+    std::vector<float> m_Weights;
+    ThreadPool m_Pool;
+    std::vector<SearchSpace> m_Spaces;
+};
+
+#endif
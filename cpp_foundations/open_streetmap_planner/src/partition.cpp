@@ -0,0 +1,43 @@
+#include "partition.h"
+#include <algorithm>
+
+Partition::Partition(const Model &model, const RouteGraph &graph, const std::vector<int> &max_cell_sizes) :
+    m_Cells(max_cell_sizes.size(), std::vector<int>(graph.NodeCount(), -1)), m_CellCounts(max_cell_sizes.size(), 0) {
+    std::vector<int> nodes;
+    for (int v = 0; v < graph.NodeCount(); ++v) {
+        if (graph.Forward().Begin(v) != graph.Forward().End(v) || graph.Backward().Begin(v) != graph.Backward().End(v)) {
+            nodes.push_back(v);
+        }
+    }
+    if (!nodes.empty() && !max_cell_sizes.empty()) {
+        Split(model, nodes.begin(), nodes.end(), LevelCount() - 1, max_cell_sizes);
+    }
+}
+
+// Levels above level already have a cell for [begin, end). Give the range a cell on every
+// level it fits into, then halve it until it fits the finest one.
+void Partition::Split(const Model &model, std::vector<int>::iterator begin, std::vector<int>::iterator end, int level,
+                      const std::vector<int> &max_cell_sizes) {
+    const auto size = end - begin;
+    while (level >= 0 && size <= max_cell_sizes[level]) {
+        const int cell = m_CellCounts[level]++;
+        for (auto it = begin; it != end; ++it) {
+            m_Cells[level][*it] = cell;
+        }
+        --level;
+    }
+    if (level < 0) {
+        return;
+    }
+
+    const auto &coordinates = model.Nodes();
+    auto [min_x, max_x] = std::minmax_element(begin, end, [&](int a, int b) { return coordinates[a].x < coordinates[b].x; });
+    auto [min_y, max_y] = std::minmax_element(begin, end, [&](int a, int b) { return coordinates[a].y < coordinates[b].y; });
+    const bool by_x = coordinates[*max_x].x - coordinates[*min_x].x >= coordinates[*max_y].y - coordinates[*min_y].y;
+    auto middle = begin + size / 2;
+    std::nth_element(begin, middle, end, [&](int a, int b) {
+        return by_x ? coordinates[a].x < coordinates[b].x : coordinates[a].y < coordinates[b].y;
+    });
+    Split(model, begin, middle, level, max_cell_sizes);
+    Split(model, middle, end, level, max_cell_sizes);
+}
@@ -0,0 +1,29 @@
+#ifndef PARTITION_H
+#define PARTITION_H
+
+#include <vector>
+#include "model.h"
+#include "route_graph.h"
+
+// Nested multi-level partition of the road graph nodes into cells, independent of edge weights.
+// Cells come from recursive bisection of node coordinates along the longer side of their
+// bounding box, so every cell of a level lies inside one cell of each coarser level.
+class Partition {
+  public:
+    // One level per entry of max_cell_sizes, finest first; sizes must increase.
+    Partition(const Model &model, const RouteGraph &graph, const std::vector<int> &max_cell_sizes = {64, 512, 4096});
+
+    int LevelCount() const { return static_cast<int>(m_Cells.size()); }
+    int CellCount(int level) const { return m_CellCounts[level]; }
+    // Cell of node v on a level, or -1 for nodes without road edges.
+    int Cell(int level, int v) const { return m_Cells[level][v]; }
+
+  private:
+    void Split(const Model &model, std::vector<int>::iterator begin, std::vector<int>::iterator end, int level,
+               const std::vector<int> &max_cell_sizes);
+
+    std::vector<std::vector<int>> m_Cells;
+    std::vector<int> m_CellCounts;
+};
+
+#endif
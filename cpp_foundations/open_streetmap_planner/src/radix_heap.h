@@ -0,0 +1,68 @@
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Monotone priority queue for integer keys, as used by Dijkstra's algorithm: a pushed key must
+// not be smaller than the last popped one. Entries sit in buckets by the highest bit in which
+// their key differs from the last popped key, so each entry moves down at most 32 times.
+class RadixHeap {
+  public:
+    using Entry = std::pair<std::uint32_t, int>;  // (key, value)
+
+    bool Empty() const { return m_Size == 0; }
+    std::size_t Size() const { return m_Size; }
+
+    void Push(std::uint32_t key, int value) {
+        m_Buckets[Bucket(key)].emplace_back(key, value);
+        ++m_Size;
+    }
+
+    // Remove and return an entry with the smallest key. The heap must not be empty.
+    Entry Pop() {
+        if (m_Buckets[0].empty()) {
+            std::size_t i = 1;
+            while (m_Buckets[i].empty()) {
+                ++i;
+            }
+            // The smallest key of the first non-empty bucket becomes the new reference, which
+            // spreads that bucket over lower buckets only.
+            std::uint32_t last = m_Buckets[i].front().first;
+            for (const Entry &entry : m_Buckets[i]) {
+                last = std::min(last, entry.first);
+            }
+            m_Last = last;
+            for (const Entry &entry : m_Buckets[i]) {
+                m_Buckets[Bucket(entry.first)].push_back(entry);
+            }
+            m_Buckets[i].clear();
+        }
+        Entry top = m_Buckets[0].back();
+        m_Buckets[0].pop_back();
+        --m_Size;
+        return top;
+    }
+
+    void Clear() {
+        for (auto &bucket : m_Buckets) {
+            bucket.clear();
+        }
+        m_Size = 0;
+        m_Last = 0;
+    }
+
+  private:
+    int Bucket(std::uint32_t key) const {
+        return key == m_Last ? 0 : 32 - __builtin_clz(key ^ m_Last);
+    }
+
+    std::array<std::vector<Entry>, 33> m_Buckets;
+    std::size_t m_Size = 0;
+    std::uint32_t m_Last = 0;
+};
+
+#endif
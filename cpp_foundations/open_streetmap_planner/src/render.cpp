@@ -27,6 +27,8 @@ void Render::Display( io2d::output_surface &surface )
     DrawRailways(surface);
     DrawHighways(surface);    
     DrawBuildings(surface);  
+    DrawIsochrone(surface);
+    DrawTrace(surface);
     DrawPath(surface);
     DrawStartPosition(surface);   
     DrawEndPosition(surface);
@@ -40,6 +42,55 @@ void Render::DrawPath(io2d::output_surface &surface) const{
 
 }
 
+void Render::DrawIsochrone(io2d::output_surface &surface) const{
+    if (m_Isochrone.hull.size() < 3) return;
+    const auto nodes = m_Model.Nodes().data();
+
+    auto pb = io2d::path_builder{};
+    pb.matrix(m_Matrix);
+    pb.new_figure( ToPoint2D(nodes[m_Isochrone.hull.front()]) );
+    for( auto it = ++m_Isochrone.hull.begin(); it != std::end(m_Isochrone.hull); ++it )
+        pb.line( ToPoint2D(nodes[*it]) );
+    pb.close_figure();
+
+    io2d::interpreted_path area{pb};
+    surface.fill(m_IsochroneFillBrush, area);
+    surface.stroke(m_IsochroneOutlineBrush, area, std::nullopt, io2d::stroke_props{2.f});
+}
+
+void Render::DrawTrace(io2d::output_surface &surface) const{
+    const auto &entries = m_Trace.Entries();
+    if (entries.empty()) return;
+    const auto nodes = m_Model.Nodes().data();
+
+    // One figure per color band and direction, so the heatmap takes a handful of fills however
+    // long the trace is.
+    constexpr int bands = 8;
+    std::vector<io2d::path_builder> figures(2 * bands);
+    std::vector<bool> used(2 * bands, false);
+    for( auto &pb : figures )
+        pb.matrix(m_Matrix);
+    float constexpr l_marker = 0.004f;
+    for( std::size_t i = 0; i < entries.size(); ++i ) {
+        const int figure = 2 * static_cast<int>(i * bands / entries.size()) + entries[i].backward;
+        const auto &node = nodes[entries[i].node];
+        auto &pb = figures[figure];
+        pb.new_figure({static_cast<float>(node.x) - l_marker / 2, static_cast<float>(node.y) - l_marker / 2});
+        pb.rel_line({l_marker, 0.f});
+        pb.rel_line({0.f, l_marker});
+        pb.rel_line({-l_marker, 0.f});
+        pb.close_figure();
+        used[figure] = true;
+    }
+    for( int figure = 0; figure < 2 * bands; ++figure ) {
+        if (!used[figure]) continue;
+        const int shade = 220 - 180 * (figure / 2) / (bands - 1);
+        io2d::brush brush{ figure % 2 ? io2d::rgba_color{40, shade / 2, 255 - shade / 2, 140}
+                                      : io2d::rgba_color{255, shade, 0, 140} };
+        surface.fill(brush, figures[figure]);
+    }
+}
+
 void Render::DrawEndPosition(io2d::output_surface &surface) const{
     if (m_Model.path.empty()) return;
     io2d::render_props aliased{ io2d::antialias::none };
@@ -48,7 +99,7 @@ void Render::DrawEndPosition(io2d::output_surface &surface) const{
     auto pb = io2d::path_builder{}; 
     pb.matrix(m_Matrix);
 
-    pb.new_figure({(float) m_Model.path.back().x, (float) m_Model.path.back().y});
+    pb.new_figure(ToPoint2D(m_Model.Nodes()[m_Model.path.back()]));
     float constexpr l_marker = 0.01f;
     pb.rel_line({l_marker, 0.f});
     pb.rel_line({0.f, l_marker});
@@ -69,7 +120,7 @@ void Render::DrawStartPosition(io2d::output_surface &surface) const{
     auto pb = io2d::path_builder{}; 
     pb.matrix(m_Matrix);
 
-    pb.new_figure({(float) m_Model.path.front().x, (float) m_Model.path.front().y});
+    pb.new_figure(ToPoint2D(m_Model.Nodes()[m_Model.path.front()]));
     float constexpr l_marker = 0.01f;
     pb.rel_line({l_marker, 0.f});
     pb.rel_line({0.f, l_marker});
@@ -141,14 +192,14 @@ io2d::interpreted_path Render::PathLine() const
     if( m_Model.path.empty() )
         return {};
 
-    const auto nodes = m_Model.path;    
+    const auto nodes = m_Model.Nodes().data();    
     
     auto pb = io2d::path_builder{};
     pb.matrix(m_Matrix);
-    pb.new_figure( ToPoint2D( m_Model.path[0]));
+    pb.new_figure( ToPoint2D( nodes[m_Model.path[0]]));
 
     for( int i=1; i< m_Model.path.size();i++ )
-        pb.line( ToPoint2D(m_Model.path[i])); 
+        pb.line( ToPoint2D(nodes[m_Model.path[i]])); 
 
       
     return io2d::interpreted_path{pb};
@@ -3,6 +3,7 @@
 #include <unordered_map>
 #include <io2d.h>
 #include "route_model.h"
+#include "search_trace.h"
 
 using namespace std::experimental;
 
@@ -11,6 +12,11 @@ class Render
 public:
     Render(RouteModel &model );
     void Display( io2d::output_surface &surface );
+    // Shade the area of an isochrone below the path; an empty one draws nothing.
+    void SetIsochrone( Isochrone isochrone ) { m_Isochrone = std::move(isochrone); }
+    // Shade the settled nodes of a search below the path, from yellow for the first to red for
+    // the last, and blue for nodes settled backward. An empty trace draws nothing.
+    void SetTrace( SearchTrace trace ) { m_Trace = std::move(trace); }
     
 private:
     void BuildRoadReps();
@@ -24,6 +30,8 @@ private:
     void DrawLanduses(io2d::output_surface &surface) const;
     void DrawStartPosition(io2d::output_surface &surface) const;
     void DrawEndPosition(io2d::output_surface &surface) const;
+    void DrawIsochrone(io2d::output_surface &surface) const;
+    void DrawTrace(io2d::output_surface &surface) const;
     void DrawPath(io2d::output_surface &surface) const;
     io2d::interpreted_path PathFromWay(const Model::Way &way) const;
     io2d::interpreted_path PathFromMP(const Model::Multipolygon &mp) const;
@@ -31,6 +39,8 @@ private:
 
     
     RouteModel &m_Model;
+    Isochrone m_Isochrone;
+    SearchTrace m_Trace;
     float m_Scale = 1.f;
     float m_PixelsInMeter = 1.f;
     io2d::matrix_2d m_Matrix;
@@ -45,6 +55,9 @@ private:
     io2d::brush m_LeisureOutlineBrush{ io2d::rgba_color{160, 248, 162} };
     io2d::stroke_props m_LeisureOutlineStrokeProps{1.f};
 
+    io2d::brush m_IsochroneFillBrush{ io2d::rgba_color{70, 130, 180, 80} };
+    io2d::brush m_IsochroneOutlineBrush{ io2d::rgba_color{70, 130, 180} };
+
     io2d::brush m_WaterFillBrush{ io2d::rgba_color{155, 201, 215} };    
         
     io2d::brush m_RailwayStrokeBrush{ io2d::rgba_color{93,93,93} };
@@ -0,0 +1,95 @@
+#include "route_cache.h"
+#include <algorithm>
+
+RouteCache::RouteCache(std::size_t memory_budget_bytes, int shard_count) {
+    shard_count = std::max(1, shard_count);
+    for (int i = 0; i < shard_count; ++i) {
+        m_Shards.push_back(std::make_unique<Shard>());
+    }
+    m_ShardBudget = memory_budget_bytes / shard_count;
+}
+
+std::uint64_t RouteCache::Key(int source, int target) {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(source)) << 32) | static_cast<std::uint32_t>(target);
+}
+
+// Approximate heap footprint of one cached route, including the list and hash map nodes.
+std::size_t RouteCache::EntryBytes(const Route &route) {
+    return sizeof(Route) + route.path.capacity() * sizeof(int) + sizeof(Shard::Entry) + 4 * sizeof(void*) +
+           sizeof(std::pair<const std::uint64_t, std::list<Shard::Entry>::iterator>) + 2 * sizeof(void*);
+}
+
+RouteCache::Shard &RouteCache::ShardOf(std::uint64_t key) {
+    // Mix the bits so neighboring node indices land in different shards.
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return *m_Shards[key % m_Shards.size()];
+}
+
+std::shared_ptr<const RouteCache::Route> RouteCache::Find(int source, int target, std::uint64_t version) {
+    const auto key = Key(source, target);
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto it = shard.index.find(key);
+    if (it == shard.index.end() || version != m_Version) {
+        m_Misses++;
+        return nullptr;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    m_Hits++;
+    return it->second->second;
+}
+
+void RouteCache::Insert(int source, int target, float distance, std::vector<int> path, std::uint64_t version) {
+    path.shrink_to_fit();
+    auto route = std::make_shared<const Route>(Route{distance, std::move(path)});
+    const std::size_t bytes = EntryBytes(*route);
+    if (bytes > m_ShardBudget) {
+        return;
+    }
+
+    const auto key = Key(source, target);
+    Shard &shard = ShardOf(key);
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    // Checked under the lock, so a route computed before Invalidate() never gets in after it.
+    if (version != m_Version) {
+        return;
+    }
+    if (auto it = shard.index.find(key); it != shard.index.end()) {
+        shard.bytes -= EntryBytes(*it->second->second);
+        shard.lru.erase(it->second);
+        shard.index.erase(it);
+    }
+    while (!shard.lru.empty() && shard.bytes + bytes > m_ShardBudget) {
+        shard.bytes -= EntryBytes(*shard.lru.back().second);
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+    shard.lru.emplace_front(key, std::move(route));
+    shard.index[key] = shard.lru.begin();
+    shard.bytes += bytes;
+}
+
+void RouteCache::Invalidate() {
+    // Lock every shard first so no Insert() can see the new version before the shards are empty.
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (auto &shard : m_Shards) {
+        locks.emplace_back(shard->mutex);
+    }
+    m_Version++;
+    for (auto &shard : m_Shards) {
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+std::size_t RouteCache::MemoryBytes() const {
+    std::size_t bytes = 0;
+    for (const auto &shard : m_Shards) {
+        std::lock_guard<std::mutex> lock{shard->mutex};
+        bytes += shard->bytes;
+    }
+    return bytes;
+}
@@ -0,0 +1,59 @@
+#ifndef ROUTE_CACHE_H
+#define ROUTE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Thread-safe LRU cache of route results keyed by the snapped start and end node indices.
+// Keys are spread over independently locked shards, each with an equal part of the memory budget.
+class RouteCache {
+  public:
+    struct Route {
+        float distance;
+        std::vector<int> path;  // Node indices from start to end.
+    };
+
+    RouteCache(std::size_t memory_budget_bytes, int shard_count = 16);
+
+    // Cached route, or nullptr on a miss. Found routes move to the front of their shard.
+    std::shared_ptr<const Route> Find(int source, int target) { return Find(source, target, m_Version); }
+    // Same, but a miss unless the cache is at version, e.g. the one belonging to the model the
+    // caller snapped its nodes on. Checked under the lock, like in Insert().
+    std::shared_ptr<const Route> Find(int source, int target, std::uint64_t version);
+    // Store a route computed against the model as of Version(), evicting the least recently
+    // used routes of the shard until it fits. Routes from an older version are dropped.
+    void Insert(int source, int target, float distance, std::vector<int> path, std::uint64_t version);
+    // Drop every route, e.g. after the model was reloaded, and start a new version.
+    void Invalidate();
+
+    std::uint64_t Version() const { return m_Version; }
+    std::uint64_t Hits() const { return m_Hits; }
+    std::uint64_t Misses() const { return m_Misses; }
+    std::size_t MemoryBytes() const;
+
+  private:
+    struct Shard {
+        using Entry = std::pair<std::uint64_t, std::shared_ptr<const Route>>;
+        mutable std::mutex mutex;
+        std::list<Entry> lru;  // Most recently used first.
+        std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+        std::size_t bytes = 0;
+    };
+
+    static std::uint64_t Key(int source, int target);
+    static std::size_t EntryBytes(const Route &route);
+    Shard &ShardOf(std::uint64_t key);
+
+    std::vector<std::unique_ptr<Shard>> m_Shards;
+    std::size_t m_ShardBudget;
+    std::atomic<std::uint64_t> m_Version{0};
+    std::atomic<std::uint64_t> m_Hits{0};
+    std::atomic<std::uint64_t> m_Misses{0};
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "route_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <tuple>
+
+RouteGraph::RouteGraph(const Model &model, Profile profile) : m_Profile(profile) {
+    const auto &nodes = model.Nodes();
+    const auto scale = model.MetricScale();
+    auto length = [&](int a, int b) {
+        return static_cast<float>(std::hypot(nodes[a].x - nodes[b].x, nodes[a].y - nodes[b].y) * scale);
+    };
+
+    // Collect the directions of every road segment the profile may travel. Pedestrians may walk
+    // one-way streets both ways.
+    const bool oneways = profile == Profile::Car;
+    std::vector<std::tuple<int, int, float, Model::Road::Type>> edges;
+    for (const Model::Road &road : model.Roads()) {
+        if (!Allows(profile, road.type)) {
+            continue;
+        }
+        const auto &way_nodes = model.Ways()[road.way].nodes;
+        for (std::size_t i = 1; i < way_nodes.size(); ++i) {
+            int a = way_nodes[i - 1];
+            int b = way_nodes[i];
+            if (a == b) {
+                continue;
+            }
+            float w = length(a, b);
+            if (!oneways || road.oneway != Model::Road::Backward) {
+                edges.emplace_back(a, b, w, road.type);
+            }
+            if (!oneways || road.oneway != Model::Road::Forward) {
+                edges.emplace_back(b, a, w, road.type);
+            }
+        }
+    }
+
+    // Sort by tail then head so parallel edges are adjacent and only the shortest one is kept.
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end(), [](const auto &e1, const auto &e2) {
+        return std::get<0>(e1) == std::get<0>(e2) && std::get<1>(e1) == std::get<1>(e2);
+    }), edges.end());
+
+    const int node_count = static_cast<int>(nodes.size());
+    m_Forward.first_out.assign(node_count + 1, 0);
+    m_Forward.head.reserve(edges.size());
+    m_Forward.weight.reserve(edges.size());
+    m_Forward.type.reserve(edges.size());
+    for (const auto &[tail, head, weight, type] : edges) {
+        ++m_Forward.first_out[tail + 1];
+        m_Forward.head.push_back(head);
+        m_Forward.weight.push_back(weight);
+        m_Forward.type.push_back(type);
+    }
+    for (int v = 0; v < node_count; ++v) {
+        m_Forward.first_out[v + 1] += m_Forward.first_out[v];
+    }
+
+    // Counting sort of the same edges by head.
+    const int edge_count = EdgeCount();
+    m_Backward.first_out.assign(node_count + 1, 0);
+    for (int head : m_Forward.head) {
+        ++m_Backward.first_out[head + 1];
+    }
+    for (int v = 0; v < node_count; ++v) {
+        m_Backward.first_out[v + 1] += m_Backward.first_out[v];
+    }
+    m_Backward.head.resize(edge_count);
+    m_Backward.weight.resize(edge_count);
+    m_Backward.type.resize(edge_count);
+    m_Backward.forward_edge.resize(edge_count);
+    std::vector<int> fill(m_Backward.first_out.begin(), m_Backward.first_out.end() - 1);
+    for (int tail = 0; tail < node_count; ++tail) {
+        for (int e = m_Forward.Begin(tail); e < m_Forward.End(tail); ++e) {
+            const int slot = fill[m_Forward.head[e]]++;
+            m_Backward.head[slot] = tail;
+            m_Backward.weight[slot] = m_Forward.weight[e];
+            m_Backward.type[slot] = m_Forward.type[e];
+            m_Backward.forward_edge[slot] = e;
+        }
+    }
+
+    LabelComponents();
+}
+
+bool RouteGraph::Allows(Profile profile, Model::Road::Type type) {
+    switch (profile) {
+        case Profile::Car: return type != Model::Road::Footway;
+        case Profile::Foot: return type != Model::Road::Motorway;
+    }
+    return false;
+}
+
+// Weak components by union-find, strong components by Tarjan's algorithm.
+void RouteGraph::LabelComponents() {
+    const auto &edges = m_Forward;
+    const int node_count = NodeCount();
+
+    // Weak components: union-find over the edges, ignoring their direction.
+    std::vector<int> root(node_count);
+    std::iota(root.begin(), root.end(), 0);
+    auto find = [&](int v) {
+        while (root[v] != v) {
+            v = root[v] = root[root[v]];
+        }
+        return v;
+    };
+    for (int u = 0; u < node_count; ++u) {
+        for (int e = edges.Begin(u); e < edges.End(u); ++e) {
+            root[find(u)] = find(edges.head[e]);
+        }
+    }
+    m_Component.assign(node_count, -1);
+    int components = 0;
+    for (int v = 0; v < node_count; ++v) {
+        int r = find(v);
+        if (m_Component[r] == -1) {
+            m_Component[r] = components++;
+        }
+        m_Component[v] = m_Component[r];
+    }
+
+    // Strong components: Tarjan's algorithm with an explicit stack of (node, next edge) frames.
+    m_StrongComponent.assign(node_count, -1);
+    std::vector<int> order(node_count, -1);
+    std::vector<int> low(node_count);
+    std::vector<int> stack;
+    std::vector<std::pair<int, int>> frames;
+    std::vector<int> sizes;
+    int visited = 0;
+    for (int start = 0; start < node_count; ++start) {
+        if (order[start] != -1) {
+            continue;
+        }
+        order[start] = low[start] = visited++;
+        stack.push_back(start);
+        frames.emplace_back(start, edges.Begin(start));
+        while (!frames.empty()) {
+            const int v = frames.back().first;
+            if (frames.back().second < edges.End(v)) {
+                const int w = edges.head[frames.back().second++];
+                if (order[w] == -1) {
+                    order[w] = low[w] = visited++;
+                    stack.push_back(w);
+                    frames.emplace_back(w, edges.Begin(w));
+                } else if (m_StrongComponent[w] == -1) {
+                    low[v] = std::min(low[v], order[w]);
+                }
+                continue;
+            }
+            frames.pop_back();
+            if (!frames.empty()) {
+                low[frames.back().first] = std::min(low[frames.back().first], low[v]);
+            }
+            if (low[v] == order[v]) {
+                const int component = static_cast<int>(sizes.size());
+                sizes.push_back(0);
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    m_StrongComponent[w] = component;
+                    ++sizes[component];
+                } while (w != v);
+            }
+        }
+    }
+    m_LargestStrongComponent = static_cast<int>(std::max_element(sizes.begin(), sizes.end()) - sizes.begin());
+}
+
+float RouteGraph::SpeedKmh(Model::Road::Type type) {
+    switch (type) {
+        case Model::Road::Motorway: return 100.0f;
+        case Model::Road::Trunk: return 80.0f;
+        case Model::Road::Primary: return 60.0f;
+        case Model::Road::Secondary: return 50.0f;
+        case Model::Road::Tertiary: return 40.0f;
+        case Model::Road::Residential: return 30.0f;
+        case Model::Road::Unclassified: return 30.0f;
+        case Model::Road::Service: return 15.0f;
+        case Model::Road::Footway: return 5.0f;
+        default: return 20.0f;
+    }
+}
+
+std::vector<float> RouteGraph::TravelTimes() const {
+    std::vector<float> seconds(m_Forward.weight.size());
+    for (std::size_t e = 0; e < seconds.size(); ++e) {
+        const float speed = m_Profile == Profile::Foot ? SpeedKmh(Model::Road::Footway) : SpeedKmh(m_Forward.type[e]);
+        seconds[e] = m_Forward.weight[e] / (speed / 3.6f);
+    }
+    return seconds;
+}
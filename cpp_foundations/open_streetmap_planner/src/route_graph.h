@@ -0,0 +1,68 @@
+#ifndef ROUTE_GRAPH_H
+#define ROUTE_GRAPH_H
+
+#include <vector>
+#include "model.h"
+
+// Road network of one travel profile as a directed compressed sparse row (CSR) graph. Vertices
+// are Model node indices for every profile and edges join consecutive nodes of every way the
+// profile may use, in each direction it may travel, weighted by their length in meters.
+class RouteGraph {
+  public:
+    // Cars drive on every road but footways, in their legal directions. Pedestrians walk on
+    // every road but motorways, in both directions.
+    enum class Profile { Car, Foot };
+    static constexpr int kProfileCount = 2;
+
+    struct Adjacency {
+        std::vector<int> first_out;  // Edges of node v are [first_out[v], first_out[v + 1]).
+        std::vector<int> head;
+        std::vector<float> weight;
+        std::vector<Model::Road::Type> type;  // Type of the road each edge belongs to.
+        // Backward() only: the Forward() edge each edge reverses. Empty in Forward().
+        std::vector<int> forward_edge;
+
+        int Begin(int v) const { return first_out[v]; }
+        int End(int v) const { return first_out[v + 1]; }
+        // Forward() id of edge e, to look up data kept per Forward() edge.
+        int ForwardEdge(int e) const { return forward_edge.empty() ? e : forward_edge[e]; }
+    };
+
+    RouteGraph(const Model &model, Profile profile = Profile::Car);
+
+    int NodeCount() const { return static_cast<int>(m_Forward.first_out.size()) - 1; }
+    int EdgeCount() const { return static_cast<int>(m_Forward.head.size()); }
+    // Outgoing edges, used by forward searches.
+    const Adjacency &Forward() const { return m_Forward; }
+    // Incoming edges, used by backward searches, with the tail of each edge stored in head. It
+    // is a CSR of its own so backward searches scan memory as linearly as forward ones.
+    const Adjacency &Backward() const { return m_Backward; }
+    Profile GetProfile() const { return m_Profile; }
+    // Free-flow travel time in seconds of every Forward() edge, from the speed of its road type
+    // for cars and at walking speed for pedestrians.
+    std::vector<float> TravelTimes() const;
+    // Assumed driving speed on a road type in km/h.
+    static float SpeedKmh(Model::Road::Type type);
+    // Whether a profile may use roads of a type.
+    static bool Allows(Profile profile, Model::Road::Type type);
+
+    // Weakly connected component of a node. Nodes in different ones cannot reach each other.
+    int Component(int v) const { return m_Component[v]; }
+    // Strongly connected component of a node. Nodes in the same one can reach each other.
+    int StrongComponent(int v) const { return m_StrongComponent[v]; }
+    int LargestStrongComponent() const { return m_LargestStrongComponent; }
+    // O(1) check before a search: false means there is no route from one node to the other.
+    bool MaybeReachable(int from, int to) const { return m_Component[from] == m_Component[to]; }
+
+  private:
+    void LabelComponents();
+
+    Profile m_Profile;
+    Adjacency m_Forward;
+    Adjacency m_Backward;
+    std::vector<int> m_Component;
+    std::vector<int> m_StrongComponent;
+    int m_LargestStrongComponent = -1;
+};
+
+#endif
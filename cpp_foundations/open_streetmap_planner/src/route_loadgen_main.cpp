@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "batch_router.h"
+#include "route_server.h"
+
+using Clock = std::chrono::steady_clock;
+
+static int Connect(const std::string &address)
+{
+    if( address.rfind("unix:", 0) == 0 ) {
+        sockaddr_un un{};
+        un.sun_family = AF_UNIX;
+        std::strncpy(un.sun_path, address.c_str() + 5, sizeof(un.sun_path) - 1);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if( fd != -1 && connect(fd, reinterpret_cast<sockaddr *>(&un), sizeof(un)) == 0 )
+            return fd;
+        if( fd != -1 )
+            close(fd);
+        return -1;
+    }
+    if( address.rfind("tcp:", 0) == 0 ) {
+        sockaddr_in in{};
+        in.sin_family = AF_INET;
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        in.sin_port = htons(static_cast<std::uint16_t>(std::stoi(address.substr(4))));
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int no_delay = 1;
+        if( fd != -1 && setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay)) == 0 &&
+            connect(fd, reinterpret_cast<sockaddr *>(&in), sizeof(in)) == 0 )
+            return fd;
+        if( fd != -1 )
+            close(fd);
+    }
+    return -1;
+}
+
+static double Percentile(std::vector<double> &values, double fraction)
+{
+    if( values.empty() )
+        return 0.0;
+    auto nth = values.begin() + std::min(values.size() - 1, static_cast<std::size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), nth, values.end());
+    return *nth;
+}
+
+// Send requests over one connection, keeping depth of them in flight, and record the latency of
+// every response. Returns false if the connection failed.
+static bool RunConnection(const std::string &address, const std::vector<RouteServer::Request> &requests,
+                          int depth, std::vector<double> &latencies_us)
+{
+    int fd = Connect(address);
+    if( fd == -1 )
+        return false;
+    std::vector<Clock::time_point> sent(requests.size());
+    std::vector<std::byte> out, in;
+    std::size_t next = 0, received = 0;
+    bool ok = true;
+    while( ok && received < requests.size() ) {
+        out.clear();
+        for( ; next < requests.size() && next - received < static_cast<std::size_t>(depth); ++next ) {
+            sent[next] = Clock::now();
+            RouteServer::AppendRequest(out, requests[next]);
+        }
+        for( std::size_t offset = 0; ok && offset < out.size(); ) {
+            ssize_t count = send(fd, out.data() + offset, out.size() - offset, MSG_NOSIGNAL);
+            ok = count > 0;
+            offset += std::max<ssize_t>(count, 0);
+        }
+        const std::size_t size = in.size();
+        in.resize(size + 64 * 1024);
+        ssize_t count = ok ? recv(fd, in.data() + size, 64 * 1024, 0) : -1;
+        in.resize(size + std::max<ssize_t>(count, 0));
+        ok = ok && count > 0;
+        std::size_t offset = 0;
+        RouteServer::Response response;
+        while( long frame = RouteServer::ParseResponse(in.data() + offset, in.size() - offset, response) ) {
+            if( frame < 0 || response.id >= requests.size() ) {
+                ok = false;
+                break;
+            }
+            latencies_us.push_back(std::chrono::duration<double, std::micro>(Clock::now() - sent[response.id]).count());
+            offset += frame;
+            ++received;
+        }
+        in.erase(in.begin(), in.begin() + offset);
+    }
+    close(fd);
+    return ok;
+}
+
+// Load generator for the routing daemon: opens some connections, keeps a number of requests in
+// flight on each and reports the throughput and latency percentiles.
+int main(int argc, const char **argv)
+{
+    std::string address = "";
+    std::string queries_file = "";
+    int connections = 4;
+    int depth = 16;
+    int requests_per_connection = 10000;
+    auto type = RouteServer::Type::Route;
+    unsigned int seed = 7;
+    for( int i = 1; i < argc; ++i ) {
+        const std::string_view arg{argv[i]};
+        if( (arg == "-unix" || arg == "-tcp") && ++i < argc )
+            address = std::string{arg.substr(1)} + ":" + argv[i];
+        else if( arg == "-connections" && ++i < argc )
+            connections = std::max(1, std::stoi(argv[i]));
+        else if( arg == "-depth" && ++i < argc )
+            depth = std::max(1, std::stoi(argv[i]));
+        else if( arg == "-requests" && ++i < argc )
+            requests_per_connection = std::max(1, std::stoi(argv[i]));
+        else if( arg == "-queries" && ++i < argc )
+            queries_file = argv[i];
+        else if( arg == "-type" && ++i < argc ) {
+            const std::string_view name{argv[i]};
+            type = name == "distance" ? RouteServer::Type::Distance
+                 : name == "snap"     ? RouteServer::Type::Snap
+                                      : RouteServer::Type::Route;
+        }
+        else if( arg == "-seed" && ++i < argc )
+            seed = static_cast<unsigned int>(std::stoul(argv[i]));
+        else {
+            address.clear();
+            break;
+        }
+    }
+    if( address.empty() ) {
+        std::cerr << "Usage: route_loadgen -unix path|-tcp port [-connections n] [-depth n] [-requests n]"
+                  << " [-queries queries.txt] [-type route|distance|snap] [-seed n]" << std::endl;
+        return 1;
+    }
+
+    // Endpoints from a batch query file, or uniformly random over the map.
+    std::vector<BatchRouter::Query> queries;
+    if( !queries_file.empty() ) {
+        std::ifstream is{queries_file};
+        queries = BatchRouter::ReadQueries(is);
+        if( queries.empty() ) {
+            std::cerr << "No queries in " << queries_file << std::endl;
+            return 1;
+        }
+    }
+    std::mt19937 random{seed};
+    std::uniform_real_distribution<float> percent{0.f, 100.f};
+    std::vector<std::vector<RouteServer::Request>> requests(connections);
+    for( auto &list : requests )
+        for( int i = 0; i < requests_per_connection; ++i ) {
+            RouteServer::Request request;
+            request.id = static_cast<std::uint32_t>(i);
+            request.type = type;
+            if( queries.empty() ) {
+                request.start_x = percent(random);
+                request.start_y = percent(random);
+                request.end_x = percent(random);
+                request.end_y = percent(random);
+            }
+            else {
+                const auto &query = queries[random() % queries.size()];
+                request.start_x = query.start_x;
+                request.start_y = query.start_y;
+                request.end_x = query.end_x;
+                request.end_y = query.end_y;
+            }
+            list.push_back(request);
+        }
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<char> ok(connections, 0);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for( int c = 0; c < connections; ++c )
+        threads.emplace_back([&, c] { ok[c] = RunConnection(address, requests[c], depth, latencies[c]); });
+    for( auto &thread : threads )
+        thread.join();
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> all;
+    for( auto &list : latencies )
+        all.insert(all.end(), list.begin(), list.end());
+    const int failed = static_cast<int>(std::count(ok.begin(), ok.end(), 0));
+    std::cout << "Answered " << all.size() << " requests over " << connections << " connections at depth " << depth
+              << " in " << seconds << " s (" << (seconds > 0.0 ? all.size() / seconds : 0.0) << " requests/s), p50 "
+              << Percentile(all, 0.50) << " us, p99 " << Percentile(all, 0.99) << " us, p99.9 "
+              << Percentile(all, 0.999) << " us" << std::endl;
+    if( failed > 0 )
+        std::cerr << failed << " connections failed." << std::endl;
+    return failed > 0 ? 1 : 0;
+}
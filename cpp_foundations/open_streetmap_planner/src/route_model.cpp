@@ -12,9 +12,17 @@ RouteModel::RouteModel(const std::vector<std::byte> &xml) : Model(xml) {
 }
 
 
+const RouteModel::Network &RouteModel::GetNetwork(RouteGraph::Profile profile) const {
+    const auto p = static_cast<std::size_t>(profile);
+    std::call_once(m_NetworkBuilt[p], [&] { m_Networks[p] = std::make_unique<Network>(*this, profile); });
+    return *m_Networks[p];
+}
+
+
 void RouteModel::CreateNodeToRoadHashmap() {
+    // The node based AStarSearch() only plans car routes.
     for (const Model::Road &road : Roads()) {
-        if (road.type != Model::Road::Type::Footway) {
+        if (RouteGraph::Allows(RouteGraph::Profile::Car, road.type)) {
             for (int node_idx : Ways()[road.way].nodes) {
                 if (node_to_road.find(node_idx) == node_to_road.end()) {
                     node_to_road[node_idx] = std::vector<const Model::Road *> ();
@@ -26,16 +34,48 @@ void RouteModel::CreateNodeToRoadHashmap() {
 }
 
 
-RouteModel::Node *RouteModel::Node::FindNeighbor(std::vector<int> node_indices) {
+void RouteModel::NewSearch() {
+    path.clear();
+    if (++generation == 0) {
+        // The counter wrapped, so old stamps could look current again. Pay for one full reset.
+        for (Node &node : m_Nodes) {
+            node.generation = 0;
+        }
+        generation = 1;
+    }
+}
+
+
+ShortestPathTree RouteModel::ShortestPaths(int source, float cutoff, RouteGraph::Profile profile) const {
+    return ShortestPathTree{Graph(profile), source, cutoff};
+}
+
+
+Isochrone RouteModel::FindIsochrone(int source, float cutoff, RouteGraph::Profile profile) const {
+    Isochrone isochrone;
+    isochrone.nodes = ShortestPaths(source, cutoff, profile).Nodes();
+    isochrone.hull = ConvexHull(Nodes(), isochrone.nodes);
+    return isochrone;
+}
+
+
+RouteModel::Node *RouteModel::Node::NeighborCandidate(int node_index) {
+    Node &node = parent_model->SNodes()[node_index];
+    node.Refresh();
+    if (this->distance(node) != 0 && !node.visited) {
+        return &node;
+    }
+    return nullptr;
+}
+
+
+RouteModel::Node *RouteModel::Node::FindNeighbor(const std::vector<int> &node_indices) {
     Node *closest_node = nullptr;
-    Node node;
 
     for (int node_index : node_indices) {
-        node = parent_model->SNodes()[node_index];
-        if (this->distance(node) != 0 && !node.visited) {
-            if (closest_node == nullptr || this->distance(node) < this->distance(*closest_node)) {
-                closest_node = &parent_model->SNodes()[node_index];
-            }
+        Node *node = NeighborCandidate(node_index);
+        if (node && (closest_node == nullptr || this->distance(*node) < this->distance(*closest_node))) {
+            closest_node = node;
         }
     }
     return closest_node;
@@ -43,16 +83,34 @@ RouteModel::Node *RouteModel::Node::FindNeighbor(std::vector<int> node_indices)
 
 
 void RouteModel::Node::FindNeighbors() {
+    Refresh();
     for (auto & road : parent_model->node_to_road[this->index]) {
-        RouteModel::Node *new_neighbor = this->FindNeighbor(parent_model->Ways()[road->way].nodes);
-        if (new_neighbor) {
-            this->neighbors.emplace_back(new_neighbor);
+        const auto &way_nodes = parent_model->Ways()[road->way].nodes;
+        if (road->oneway == Model::Road::No) {
+            RouteModel::Node *new_neighbor = this->FindNeighbor(way_nodes);
+            if (new_neighbor) {
+                this->neighbors.emplace_back(new_neighbor);
+            }
+            continue;
+        }
+        // On a one-way road only the next node in the direction of travel is a neighbor. A
+        // closed way passes its first node twice, so check every position of this node.
+        const int step = road->oneway == Model::Road::Forward ? 1 : -1;
+        for (int i = 0; i < static_cast<int>(way_nodes.size()); ++i) {
+            const int next = i + step;
+            if (way_nodes[i] != this->index || next < 0 || next >= static_cast<int>(way_nodes.size())) {
+                continue;
+            }
+            RouteModel::Node *new_neighbor = this->NeighborCandidate(way_nodes[next]);
+            if (new_neighbor) {
+                this->neighbors.emplace_back(new_neighbor);
+            }
         }
     }
 }
 
 
-RouteModel::Node &RouteModel::FindClosestNode(float x, float y) {
+RouteModel::Node &RouteModel::FindClosestNode(float x, float y, bool largest_component_only, RouteGraph::Profile profile) {
     Node input;
     input.x = x;
     input.y = y;
@@ -61,9 +119,14 @@ RouteModel::Node &RouteModel::FindClosestNode(float x, float y) {
     float dist;
     int closest_idx;
 
+    // Only build the graph when its components are needed.
+    const RouteGraph *graph = largest_component_only ? &Graph(profile) : nullptr;
     for (const Model::Road &road : Roads()) {
-        if (road.type != Model::Road::Type::Footway) {
+        if (RouteGraph::Allows(profile, road.type)) {
             for (int node_idx : Ways()[road.way].nodes) {
+                if (graph && graph->StrongComponent(node_idx) != graph->LargestStrongComponent()) {
+                    continue;
+                }
                 dist = input.distance(SNodes()[node_idx]);
                 if (dist < min_dist) {
                     closest_idx = node_idx;
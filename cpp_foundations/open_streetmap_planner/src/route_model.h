@@ -1,10 +1,16 @@
 #ifndef ROUTE_MODEL_H
 #define ROUTE_MODEL_H
 
+#include <array>
 #include <limits>
 #include <cmath>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include "model.h"
+#include "route_graph.h"
+#include "shortest_path_tree.h"
+#include "turn_table.h"
 #include <iostream>
 
 class RouteModel : public Model {
@@ -19,28 +25,78 @@ class RouteModel : public Model {
         std::vector<Node *> neighbors;
 
         void FindNeighbors();
+        // Clear search state left over from an earlier query, if any.
+        void Refresh() {
+            if (generation == parent_model->generation) {
+                return;
+            }
+            parent = nullptr;
+            h_value = std::numeric_limits<float>::max();
+            g_value = 0.0;
+            visited = false;
+            neighbors.clear();
+            generation = parent_model->generation;
+        }
         float distance(Node other) const {
             return std::sqrt(std::pow((x - other.x), 2) + std::pow((y - other.y), 2));
         }
 
+        int Index() const { return index; }
+
         Node(){}
         Node(int idx, RouteModel * search_model, Model::Node node) : Model::Node(node), parent_model(search_model), index(idx) {}
 
       private:
+        friend class RouteModel;
         int index;
-        Node * FindNeighbor(std::vector<int> node_indices);
+        unsigned int generation = 0;
+        Node * FindNeighbor(const std::vector<int> &node_indices);
+        // The node at node_index if it can be a neighbor: unvisited and not at this node's spot.
+        Node * NeighborCandidate(int node_index);
         RouteModel * parent_model = nullptr;
     };
 
     RouteModel(const std::vector<std::byte> &xml);
-    Node &FindClosestNode(float x, float y);
+    // Closest node to (x, y) on a road the profile may use, optionally only among nodes of the
+    // largest strongly connected component so that any two snapped points can reach each other.
+    Node &FindClosestNode(float x, float y, bool largest_component_only = false,
+                          RouteGraph::Profile profile = RouteGraph::Profile::Car);
     auto &SNodes() { return m_Nodes; }
-    std::vector<Node> path;
+    // Routing graph of a profile. Each one is built on first use, from any thread, and kept for
+    // the lifetime of the model; all of them share the model's nodes.
+    const RouteGraph &Graph(RouteGraph::Profile profile = RouteGraph::Profile::Car) const {
+        return GetNetwork(profile).graph;
+    }
+    // Turn restrictions of the map over the edges of Graph(profile), for turn-aware searches.
+    const TurnTable &Turns(RouteGraph::Profile profile = RouteGraph::Profile::Car) const {
+        return GetNetwork(profile).turns;
+    }
+    // Shortest paths from source to every node within cutoff meters on Graph(profile).
+    ShortestPathTree ShortestPaths(int source, float cutoff = std::numeric_limits<float>::infinity(),
+                                   RouteGraph::Profile profile = RouteGraph::Profile::Car) const;
+    // Nodes within cutoff meters of source along the roads of a profile, with a polygon around them.
+    Isochrone FindIsochrone(int source, float cutoff, RouteGraph::Profile profile = RouteGraph::Profile::Car) const;
+    // Start a new search. Node state from earlier searches is invalidated in O(1) and
+    // cleared lazily the next time each node is touched.
+    void NewSearch();
+    // Node indices of the last route found, from start to end. Look coordinates up in Nodes().
+    std::vector<int> path;
     
   private:
+    // Routing graph of one profile and the turn table over its edges.
+    struct Network {
+        Network(const Model &model, RouteGraph::Profile profile) : graph(model, profile), turns(model, graph) {}
+        RouteGraph graph;
+        TurnTable turns;
+    };
+
     void CreateNodeToRoadHashmap();
+    const Network &GetNetwork(RouteGraph::Profile profile) const;
+    unsigned int generation = 0;
     std::unordered_map<int, std::vector<const Model::Road *>> node_to_road;
     std::vector<Node> m_Nodes;
+    mutable std::array<std::unique_ptr<Network>, RouteGraph::kProfileCount> m_Networks;
+    mutable std::array<std::once_flag, RouteGraph::kProfileCount> m_NetworkBuilt;
 
 };
 
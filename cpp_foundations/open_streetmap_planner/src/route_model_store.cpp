@@ -0,0 +1,111 @@
+#include "route_model_store.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+// Slot value of a reader that holds no version.
+constexpr std::uint64_t kIdle = std::numeric_limits<std::uint64_t>::max();
+
+}  // namespace
+
+RouteModelStore::Reader::~Reader() {
+    if (m_Slot) {
+        m_Slot->store(kIdle, std::memory_order_release);
+    }
+}
+
+std::unique_ptr<RouteModelStore::Version> RouteModelStore::Load(const std::string &osm_file, const std::string &ch_file) {
+    std::ifstream is{osm_file, std::ios::binary | std::ios::ate};
+    if (!is) {
+        return nullptr;
+    }
+    std::vector<std::byte> osm_data(is.tellg());
+    is.seekg(0);
+    is.read(reinterpret_cast<char *>(osm_data.data()), osm_data.size());
+    if (!is || osm_data.empty()) {
+        return nullptr;
+    }
+
+    auto version = std::make_unique<Version>();
+    version->owned_model = std::make_unique<RouteModel>(osm_data);
+    const RouteGraph &graph = version->owned_model->Graph();
+    if (auto hierarchy = ch_file.empty() ? std::nullopt : ContractionHierarchy::Load(ch_file, graph)) {
+        version->owned_hierarchy = std::make_unique<ContractionHierarchy>(std::move(*hierarchy));
+    }
+    else {
+        version->owned_hierarchy = std::make_unique<ContractionHierarchy>(graph);
+        if (!ch_file.empty() && !version->owned_hierarchy->Save(ch_file)) {
+            std::cerr << "Failed to write " << ch_file << std::endl;
+        }
+    }
+    version->model = version->owned_model.get();
+    version->hierarchy = version->owned_hierarchy.get();
+    return version;
+}
+
+RouteModelStore::RouteModelStore(int reader_count) :
+    m_ReaderCount(reader_count), m_Slots(std::make_unique<Slot[]>(reader_count)) {
+    for (int i = 0; i < reader_count; ++i) {
+        m_Slots[i].epoch.store(kIdle);
+    }
+}
+
+RouteModelStore::~RouteModelStore() {
+    delete m_Current.load();
+}
+
+std::uint64_t RouteModelStore::Publish(std::unique_ptr<Version> version) {
+    std::lock_guard<std::mutex> lock{m_PublishMutex};
+    const int node_count = version->hierarchy->NodeCount();
+    version->forward.assign(m_ReaderCount, SearchSpace{node_count});
+    version->backward.assign(m_ReaderCount, SearchSpace{node_count});
+    version->number = m_NextNumber++;
+    const std::uint64_t number = version->number;
+
+    // A reader that announced an epoch before the increment may have loaded the old version; one
+    // that announced the new epoch loads the pointer after the swap. All accesses are
+    // sequentially consistent so that either the reader's slot is seen by Reclaim() or the
+    // reader sees the swap.
+    Version *previous = m_Current.exchange(version.release());
+    const std::uint64_t epoch = m_Epoch.fetch_add(1) + 1;
+    m_CurrentNumber.store(number);
+    if (previous) {
+        m_Retired.push_back({std::unique_ptr<Version>{previous}, epoch});
+    }
+    return number;
+}
+
+bool RouteModelStore::Reclaim() {
+    std::vector<std::unique_ptr<Version>> unused;
+    {
+        std::lock_guard<std::mutex> lock{m_PublishMutex};
+        std::uint64_t oldest = kIdle;
+        for (int i = 0; i < m_ReaderCount; ++i) {
+            oldest = std::min(oldest, m_Slots[i].epoch.load());
+        }
+        auto kept = std::partition(m_Retired.begin(), m_Retired.end(),
+                                   [&](const Retired &retired) { return retired.epoch > oldest; });
+        for (auto it = kept; it != m_Retired.end(); ++it) {
+            unused.push_back(std::move(it->version));
+        }
+        m_Retired.erase(kept, m_Retired.end());
+        if (!m_Retired.empty()) {
+            return false;
+        }
+    }
+    // Versions are freed here, outside the lock.
+    return true;
+}
+
+RouteModelStore::Reader RouteModelStore::Read(int reader) const {
+    std::atomic<std::uint64_t> &slot = m_Slots[reader].epoch;
+    slot.store(m_Epoch.load());
+    return Reader{&slot, m_Current.load()};
+}
+
+std::uint64_t RouteModelStore::CurrentVersion() const {
+    return m_CurrentNumber.load();
+}
@@ -0,0 +1,99 @@
+#ifndef ROUTE_MODEL_STORE_H
+#define ROUTE_MODEL_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "contraction_hierarchy.h"
+#include "route_model.h"
+#include "search_space.h"
+
+// Current version of the routing data of a server, replaced while queries run on it. Readers
+// are a fixed set of threads, such as the workers of a pool, that pin the current version for
+// the length of a query without taking a lock. Publishing a new version swaps one pointer;
+// queries in flight finish on the old version, which is freed once no reader can still hold it
+// (epoch-based reclamation). Readers announce the epoch they started in and retired versions
+// wait until every reader is idle or started in a later epoch.
+class RouteModelStore {
+  public:
+    struct Version {
+        std::uint64_t number = 0;
+        RouteModel *model = nullptr;
+        const ContractionHierarchy *hierarchy = nullptr;
+        // Search spaces of every reader, sized for this version's nodes by Publish().
+        std::vector<SearchSpace> forward;
+        std::vector<SearchSpace> backward;
+        // Set when the version owns its data, as after Load().
+        std::unique_ptr<RouteModel> owned_model;
+        std::unique_ptr<ContractionHierarchy> owned_hierarchy;
+        // Version of a route cache in front of this model, set by the owner of the cache.
+        std::uint64_t cache_version = 0;
+    };
+
+    // Pins the version current when it was made until it goes out of scope.
+    class Reader {
+      public:
+        Reader(Reader &&other) noexcept : m_Slot(other.m_Slot), m_Version(other.m_Version) { other.m_Slot = nullptr; }
+        Reader(const Reader &) = delete;
+        Reader &operator=(const Reader &) = delete;
+        ~Reader();
+
+        // Readers may only use their own search spaces of the version.
+        Version &operator*() const { return *m_Version; }
+        Version *operator->() const { return m_Version; }
+
+      private:
+        friend class RouteModelStore;
+        Reader(std::atomic<std::uint64_t> *slot, Version *version) : m_Slot(slot), m_Version(version) {}
+
+        std::atomic<std::uint64_t> *m_Slot;
+        Version *m_Version;
+    };
+
+    // Read the map, then load the contraction hierarchy from ch_file or build it, saving it there
+    // when the file is missing or was built for another map. Returns nothing if the map can't be
+    // read. Slow; meant for a background thread.
+    static std::unique_ptr<Version> Load(const std::string &osm_file, const std::string &ch_file = "");
+
+    RouteModelStore(int reader_count);
+    // No reader may be active any more.
+    ~RouteModelStore();
+    RouteModelStore(const RouteModelStore &) = delete;
+    RouteModelStore &operator=(const RouteModelStore &) = delete;
+
+    // Make version current, allocating its search spaces on the calling thread first, and retire
+    // the previous one. Returns the new version number, counting from 1.
+    std::uint64_t Publish(std::unique_ptr<Version> version);
+    // Free the retired versions no reader can hold any more. Returns whether none are left. Call
+    // from the publishing thread rather than a reader, as freeing a map takes a while.
+    bool Reclaim();
+
+    // Pin the current version for reader, in [0, reader_count). Each reader pins at most one
+    // version at a time. There must be a current version.
+    Reader Read(int reader) const;
+    std::uint64_t CurrentVersion() const;
+
+  private:
+    // Padded so readers don't share cache lines.
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> epoch;
+    };
+    struct Retired {
+        std::unique_ptr<Version> version;
+        std::uint64_t epoch;  // Readers that started in this epoch or later can't see the version.
+    };
+
+    int m_ReaderCount;
+    std::unique_ptr<Slot[]> m_Slots;
+    std::atomic<std::uint64_t> m_Epoch{1};
+    std::atomic<Version *> m_Current{nullptr};
+    std::atomic<std::uint64_t> m_CurrentNumber{0};
+    std::mutex m_PublishMutex;
+    std::uint64_t m_NextNumber = 1;
+    std::vector<Retired> m_Retired;
+};
+
+#endif
@@ -1,22 +1,76 @@
 #include "route_planner.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
 
-RoutePlanner::RoutePlanner(RouteModel &model, float start_x, float start_y, float end_x, float end_y): m_Model(model) {
+template <typename Cost>
+BasicRoutePlanner<Cost>::BasicRoutePlanner(RouteModel &model, Cost cost, RouteGraph::Profile profile):
+    cost(cost), profile(profile), m_Model(model), m_Graph(model.Graph(profile)), forward_space(m_Graph.NodeCount()),
+    backward_space(m_Graph.NodeCount()), local_space(m_Graph.NodeCount()), edge_space(m_Graph.EdgeCount()) {
+  // Travel times depend on the profile, so the policy has to be built for the one planned on.
+  if constexpr (std::is_same_v<Cost, TravelTimeCost>) {
+    if (cost.GetProfile() != profile) {
+      throw std::invalid_argument("travel time cost is for a different profile than the planner");
+    }
+  }
+}
+
+template <typename Cost>
+BasicRoutePlanner<Cost>::BasicRoutePlanner(RouteModel &model, float start_x, float start_y, float end_x, float end_y, Cost cost,
+                                           RouteGraph::Profile profile):
+    BasicRoutePlanner(model, cost, profile) {
+    SetEndpoints(start_x, start_y, end_x, end_y);
+}
+
+template <typename Cost>
+BasicRoutePlanner<Cost>::BasicRoutePlanner(RouteModel &model, RouteModel::Node &start, RouteModel::Node &end, double snap_us,
+                                           Cost cost, RouteGraph::Profile profile):
+    BasicRoutePlanner(model, cost, profile) {
+    start_node = &start;
+    end_node = &end;
+    stats.snap_us = snap_us;
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::SetLandmarks(const Landmarks *landmarks) {
+  // Distances on another profile's graph are no lower bounds here, e.g. car distances for walks.
+  if (landmarks != nullptr && landmarks->GetProfile() != profile) {
+    throw std::invalid_argument("landmarks are for a different profile than the planner");
+  }
+  this->landmarks = landmarks;
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::SetEndpoints(float start_x, float start_y, float end_x, float end_y) {
     // Convert inputs to percentage:
     start_x *= 0.01;
     start_y *= 0.01;
     end_x *= 0.01;
     end_y *= 0.01;
 
-    start_node = &(m_Model.FindClosestNode(start_x, start_y));
-    end_node = &(m_Model.FindClosestNode(end_x, end_y));
+    SearchTimer timer(stats.snap_us);
+    start_node = &(m_Model.FindClosestNode(start_x, start_y, largest_component_only, profile));
+    end_node = &(m_Model.FindClosestNode(end_x, end_y, largest_component_only, profile));
 }
 
-float RoutePlanner::CalculateHValue(RouteModel::Node const* node) {
-  return node->distance(*end_node);
+template <typename Cost>
+float BasicRoutePlanner<Cost>::CalculateHValue(RouteModel::Node const* node) {
+  float h_value = node->distance(*end_node);
+  if (landmarks) {
+    // Landmark bounds are in meters, the node coordinates are scaled by the map size.
+    h_value = std::max(h_value, static_cast<float>(landmarks->LowerBound(node->Index(), end_node->Index()) / m_Model.MetricScale()));
+  }
+  return h_value;
 }
 
-void RoutePlanner::AddNeighbors(RouteModel::Node* current_node) {
+template <typename Cost>
+void BasicRoutePlanner<Cost>::AddNeighbors(RouteModel::Node* current_node) {
   current_node->FindNeighbors();
   for (RouteModel::Node* p_node: current_node->neighbors){
     p_node->h_value = CalculateHValue(p_node);
@@ -24,10 +78,17 @@ void RoutePlanner::AddNeighbors(RouteModel::Node* current_node) {
     p_node->parent = current_node;
     p_node->visited = true;
     open_list.push_back(p_node);
+    stats.relaxed_edges++;
+    stats.heap_pushes++;
   }
+  stats.max_open_list = std::max(stats.max_open_list, static_cast<int>(open_list.size()));
 }
 
-RouteModel::Node* RoutePlanner::NextNode() {
+template <typename Cost>
+RouteModel::Node* BasicRoutePlanner<Cost>::NextNode() {
+  if (open_list.empty()) {
+    return nullptr;
+  }
   // Sort list by f value which is g value + h value
   // Use lambda function with std::sort to sort the list
   std::sort(open_list.begin(), open_list.end(),
@@ -37,36 +98,622 @@ RouteModel::Node* RoutePlanner::NextNode() {
   // Grab a pointer to the node with the lowest f value then remove that node from open list
   RouteModel::Node* next_node = open_list.back();
   open_list.pop_back();
+  stats.heap_pops++;
 
   return next_node;
 }
 
-std::vector<RouteModel::Node> RoutePlanner::ConstructFinalPath(RouteModel::Node* current_node) {
-    // Create path_found vector
+template <typename Cost>
+std::vector<int> BasicRoutePlanner<Cost>::ConstructFinalPath(RouteModel::Node* current_node) {
+    // Count the nodes first so the path is allocated once and filled from the end.
     distance = 0.0f;
-    std::vector<RouteModel::Node> path_found;
+    std::size_t length = 1;
+    for (RouteModel::Node* node = current_node; node != start_node; node = node->parent) {
+      length++;
+    }
+    std::vector<int> path_found(length);
     while (current_node != start_node){
-      path_found.push_back(*current_node);
+      path_found[--length] = current_node->Index();
       distance += current_node->distance(*(current_node->parent));
       current_node = current_node->parent;
     }
     // Add the start node
-    path_found.push_back(*(start_node));
-    // Reverse order of vector so it is start to end order
-    std::reverse(path_found.begin(), path_found.end());
+    path_found[0] = start_node->Index();
 
     distance *= m_Model.MetricScale(); // Multiply the distance by the scale of the map to get meters.
     return path_found;
 }
 
-void RoutePlanner::AStarSearch() {
+template <typename Cost>
+void BasicRoutePlanner<Cost>::AStarSearch() {
+    // Invalidate the state left behind by any earlier search on this model.
+    m_Model.NewSearch();
+    open_list.clear();
+    distance = 0.0f;
+    route_cost = 0.0f;
+    ResetStats();
+    SearchTimer timer(stats.search_us);
+    if (!m_Model.Graph().MaybeReachable(start_node->Index(), end_node->Index())) {
+      std::cout << "No route between the start and end nodes\n";
+      return;
+    }
+
     RouteModel::Node* current_node = nullptr;
     current_node = start_node;
+    start_node->Refresh();
     start_node->visited = true;
     while (current_node != end_node){
       AddNeighbors(current_node);
       current_node = NextNode();
+      if (current_node == nullptr) {
+        // The open list ran dry without reaching the end node.
+        std::cout << "No route between the start and end nodes\n";
+        return;
+      }
+      stats.settled_nodes++;
+      if (trace) {
+        trace->Record(current_node->Index());
+      }
     }
     m_Model.path = ConstructFinalPath(current_node);
+    route_cost = distance;
     std::cout << "Finished search algorithm\n";
 }
+
+template <typename Cost>
+float BasicRoutePlanner<Cost>::GraphHValue(int from, int to) const {
+  const auto &nodes = m_Model.Nodes();
+  float h_value = static_cast<float>(std::hypot(nodes[from].x - nodes[to].x, nodes[from].y - nodes[to].y) * m_Model.MetricScale());
+  if (landmarks) {
+    h_value = std::max(h_value, landmarks->LowerBound(from, to));
+  }
+  // Both bounds are in meters; the policy turns them into a bound on the remaining cost.
+  return cost.CostOfMeters(h_value);
+}
+
+template <typename Cost>
+float BasicRoutePlanner<Cost>::PathLength(const std::vector<int> &path) const {
+  const RouteGraph::Adjacency &graph = m_Graph.Forward();
+  float length = 0.0f;
+  for (std::size_t i = 1; i < path.size(); ++i) {
+    for (int e = graph.Begin(path[i - 1]); e < graph.End(path[i - 1]); ++e) {
+      if (graph.head[e] == path[i]) {
+        length += graph.weight[e];
+        break;
+      }
+    }
+  }
+  return length;
+}
+
+namespace {
+// Open list entries are (key, node index) pairs; stale entries are skipped when popped. Pushes,
+// pops and the largest size are counted into the stats of the running search.
+class GraphQueue {
+ public:
+  explicit GraphQueue(SearchStats &stats) : stats(stats) {}
+
+  bool empty() const { return queue.empty(); }
+  const std::pair<float, int> &top() const { return queue.top(); }
+  void emplace(float key, int v) {
+    queue.emplace(key, v);
+    stats.heap_pushes++;
+    stats.max_open_list = std::max(stats.max_open_list, static_cast<int>(queue.size()));
+  }
+  void pop() {
+    queue.pop();
+    stats.heap_pops++;
+  }
+
+ private:
+  std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> queue;
+  SearchStats &stats;
+};
+}  // namespace
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::ResetStats() {
+  // The endpoints may have been snapped before this search, so their time is kept.
+  const double snap_us = stats.snap_us;
+  stats = SearchStats{};
+  stats.snap_us = snap_us;
+  if (trace) {
+    trace->Clear();
+  }
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::TraceSettled(const SearchSpace &space, bool backward) {
+  std::vector<std::pair<float, int>> settled;
+  for (int v = 0; v < m_Graph.NodeCount(); ++v) {
+    if (space.Settled(v)) {
+      settled.emplace_back(space.Distance(v), v);
+    }
+  }
+  std::sort(settled.begin(), settled.end());
+  for (const auto &entry : settled) {
+    trace->Record(entry.second, backward);
+  }
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::GraphAStarSearch() {
+  const RouteGraph::Adjacency &graph = m_Graph.Forward();
+  const int source = start_node->Index();
+  const int target = end_node->Index();
+  m_Model.NewSearch();
+  forward_space.Clear();
+  distance = 0.0f;
+  route_cost = 0.0f;
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  if (!m_Graph.MaybeReachable(source, target)) {
+    return;
+  }
+
+  GraphQueue queue{stats};
+  forward_space.Reach(source, 0.0f, -1);
+  queue.emplace(GraphHValue(source, target), source);
+  while (!queue.empty()) {
+    int u = queue.top().second;
+    queue.pop();
+    if (forward_space.Settled(u)) {
+      continue;
+    }
+    forward_space.Settle(u);
+    stats.settled_nodes++;
+    if (trace) {
+      trace->Record(u);
+    }
+    if (u == target) {
+      break;
+    }
+    for (int e = graph.Begin(u); e < graph.End(u); ++e) {
+      stats.relaxed_edges++;
+      int v = graph.head[e];
+      float g_value = forward_space.Distance(u) + cost.EdgeCost(graph, e);
+      if (g_value < forward_space.Distance(v)) {
+        forward_space.Reach(v, g_value, u);
+        queue.emplace(g_value + GraphHValue(v, target), v);
+      }
+    }
+  }
+
+  // NewSearch() emptied the path but kept its buffer, so it is filled in place.
+  std::vector<int> &path = m_Model.path;
+  if (forward_space.Settled(target)) {
+    for (int v = target; v != -1; v = forward_space.Parent(v)) {
+      path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    route_cost = forward_space.Distance(target);
+    distance = PathLength(m_Model.path);
+  }
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::TurnAwareSearch() {
+  const RouteGraph::Adjacency &graph = m_Graph.Forward();
+  const TurnTable &turns = m_Model.Turns(profile);
+  const int source = start_node->Index();
+  const int target = end_node->Index();
+  m_Model.NewSearch();
+  edge_space.Clear();
+  distance = 0.0f;
+  route_cost = 0.0f;
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  if (!m_Graph.MaybeReachable(source, target)) {
+    return;
+  }
+  if (source == target) {
+    m_Model.path.push_back(source);
+    return;
+  }
+
+  // Entries are keyed by the edge a route arrives on, so a node can be passed several times
+  // from different directions when a restriction forces a detour around it.
+  GraphQueue queue{stats};
+  for (int e = graph.Begin(source); e < graph.End(source); ++e) {
+    stats.relaxed_edges++;
+    float g_value = cost.EdgeCost(graph, e);
+    if (g_value < edge_space.Distance(e)) {
+      edge_space.Reach(e, g_value, -1);
+      queue.emplace(g_value + GraphHValue(graph.head[e], target), e);
+    }
+  }
+  int last = -1;
+  while (!queue.empty()) {
+    int e = queue.top().second;
+    queue.pop();
+    if (edge_space.Settled(e)) {
+      continue;
+    }
+    edge_space.Settle(e);
+    stats.settled_nodes++;
+    const int u = graph.head[e];
+    if (trace) {
+      trace->Record(u);
+    }
+    if (u == target) {
+      last = e;
+      break;
+    }
+    for (int next = graph.Begin(u); next < graph.End(u); ++next) {
+      stats.relaxed_edges++;
+      float turn = turns.Cost(e, next, turn_costs);
+      if (std::isinf(turn)) {
+        continue;
+      }
+      float g_value = edge_space.Distance(e) + turn + cost.EdgeCost(graph, next);
+      if (g_value < edge_space.Distance(next)) {
+        edge_space.Reach(next, g_value, e);
+        queue.emplace(g_value + GraphHValue(graph.head[next], target), next);
+      }
+    }
+  }
+
+  if (last != -1) {
+    std::vector<int> &path = m_Model.path;
+    for (int e = last; e != -1; e = edge_space.Parent(e)) {
+      path.push_back(graph.head[e]);
+    }
+    path.push_back(source);
+    std::reverse(path.begin(), path.end());
+    route_cost = edge_space.Distance(last);
+    distance = PathLength(m_Model.path);
+  }
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::BidirectionalAStarSearch() {
+  const RouteGraph &graph = m_Graph;
+  const int source = start_node->Index();
+  const int target = end_node->Index();
+  m_Model.NewSearch();
+  forward_space.Clear();
+  backward_space.Clear();
+  distance = 0.0f;
+  route_cost = 0.0f;
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  if (!m_Graph.MaybeReachable(source, target)) {
+    return;
+  }
+
+  // Average of the forward and backward straight-line potentials. The backward potential is its
+  // negation, so both searches see the same consistent reduced edge costs and can stop as soon
+  // as the two open list minimums add up to the best meeting distance found so far.
+  auto potential = [&](int v) { return 0.5f * (GraphHValue(v, target) - GraphHValue(source, v)); };
+
+  GraphQueue forward_queue{stats};
+  GraphQueue backward_queue{stats};
+  forward_space.Reach(source, 0.0f, -1);
+  forward_queue.emplace(potential(source), source);
+  backward_space.Reach(target, 0.0f, -1);
+  backward_queue.emplace(-potential(target), target);
+
+  float best = source == target ? 0.0f : std::numeric_limits<float>::infinity();
+  int meeting_node = source == target ? source : -1;
+  auto drop_settled = [](GraphQueue &queue, const SearchSpace &space) {
+    while (!queue.empty() && space.Settled(queue.top().second)) {
+      queue.pop();
+    }
+  };
+
+  while (true) {
+    drop_settled(forward_queue, forward_space);
+    drop_settled(backward_queue, backward_space);
+    if (forward_queue.empty() || backward_queue.empty() ||
+        forward_queue.top().first + backward_queue.top().first >= best) {
+      break;
+    }
+
+    // Expand the side with the smaller key so the two frontiers grow in balance.
+    bool forward = forward_queue.top().first <= backward_queue.top().first;
+    GraphQueue &queue = forward ? forward_queue : backward_queue;
+    SearchSpace &space = forward ? forward_space : backward_space;
+    const SearchSpace &other_space = forward ? backward_space : forward_space;
+    const RouteGraph::Adjacency &adjacency = forward ? graph.Forward() : graph.Backward();
+    const float sign = forward ? 1.0f : -1.0f;
+
+    int u = queue.top().second;
+    queue.pop();
+    space.Settle(u);
+    stats.settled_nodes++;
+    if (trace) {
+      trace->Record(u, !forward);
+    }
+    for (int e = adjacency.Begin(u); e < adjacency.End(u); ++e) {
+      stats.relaxed_edges++;
+      int v = adjacency.head[e];
+      float g_value = space.Distance(u) + cost.EdgeCost(adjacency, e);
+      if (g_value < space.Distance(v)) {
+        space.Reach(v, g_value, u);
+        queue.emplace(g_value + sign * potential(v), v);
+        if (other_space.Reached(v) && g_value + other_space.Distance(v) < best) {
+          best = g_value + other_space.Distance(v);
+          meeting_node = v;
+        }
+      }
+    }
+  }
+
+  std::vector<int> &path = m_Model.path;
+  if (meeting_node != -1) {
+    for (int v = meeting_node; v != -1; v = forward_space.Parent(v)) {
+      path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    for (int v = backward_space.Parent(meeting_node); v != -1; v = backward_space.Parent(v)) {
+      path.push_back(v);
+    }
+    route_cost = best;
+    distance = PathLength(m_Model.path);
+  }
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::ContractionHierarchySearch(const ContractionHierarchy &hierarchy) {
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  m_Model.NewSearch();
+  if (!m_Graph.MaybeReachable(start_node->Index(), end_node->Index())) {
+    distance = route_cost = 0.0f;
+    return;
+  }
+  auto result = hierarchy.Search(start_node->Index(), end_node->Index(), forward_space, backward_space);
+  stats.settled_nodes = result.settled_nodes;
+  if (trace) {
+    TraceSettled(forward_space, false);
+    TraceSettled(backward_space, true);
+  }
+  distance = result.meeting_node == -1 ? 0.0f : result.distance;
+  route_cost = distance;
+  m_Model.path = hierarchy.UnpackPath(result, forward_space, backward_space);
+}
+
+template <typename Cost>
+void BasicRoutePlanner<Cost>::OverlaySearch(const Overlay &overlay) {
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  m_Model.NewSearch();
+  if (!m_Graph.MaybeReachable(start_node->Index(), end_node->Index())) {
+    distance = route_cost = 0.0f;
+    return;
+  }
+  auto result = overlay.Query(start_node->Index(), end_node->Index(), forward_space);
+  stats.settled_nodes = result.settled_nodes;
+  if (trace) {
+    TraceSettled(forward_space, false);
+  }
+  route_cost = result.path.empty() ? 0.0f : result.distance;
+  m_Model.path = std::move(result.path);
+  distance = PathLength(m_Model.path);
+}
+
+namespace {
+// Limits for alternative routes, relative to the cost of the optimal route.
+constexpr float kMaxStretch = 0.25f;
+constexpr float kMaxSharing = 0.8f;
+constexpr float kLocalOptimality = 0.25f;
+// Distinct via routes examined before giving up on finding more alternatives.
+constexpr int kMaxCandidates = 32;
+
+std::uint64_t EdgeKey(int tail, int head) {
+  return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(tail)) << 32) | static_cast<std::uint32_t>(head);
+}
+}  // namespace
+
+template <typename Cost>
+float BasicRoutePlanner<Cost>::BoundedCost(int from, int to, float limit) {
+  const RouteGraph::Adjacency &graph = m_Graph.Forward();
+  local_space.Clear();
+  GraphQueue queue{stats};
+  local_space.Reach(from, 0.0f, -1);
+  queue.emplace(GraphHValue(from, to), from);
+  while (!queue.empty() && queue.top().first < limit) {
+    int u = queue.top().second;
+    queue.pop();
+    if (local_space.Settled(u)) {
+      continue;
+    }
+    local_space.Settle(u);
+    if (u == to) {
+      return local_space.Distance(u);
+    }
+    for (int e = graph.Begin(u); e < graph.End(u); ++e) {
+      stats.relaxed_edges++;
+      float g_value = local_space.Distance(u) + cost.EdgeCost(graph, e);
+      if (g_value < local_space.Distance(graph.head[e])) {
+        local_space.Reach(graph.head[e], g_value, u);
+        queue.emplace(g_value + GraphHValue(graph.head[e], to), graph.head[e]);
+      }
+    }
+  }
+  return limit;
+}
+
+template <typename Cost>
+std::vector<typename BasicRoutePlanner<Cost>::Route> BasicRoutePlanner<Cost>::AlternativeRoutes(int max_alternatives) {
+  const RouteGraph &graph = m_Graph;
+  const int source = start_node->Index();
+  const int target = end_node->Index();
+  m_Model.NewSearch();
+  forward_space.Clear();
+  backward_space.Clear();
+  distance = 0.0f;
+  route_cost = 0.0f;
+  ResetStats();
+  SearchTimer timer(stats.search_us);
+  if (!m_Graph.MaybeReachable(source, target)) {
+    return {};
+  }
+
+  // Bidirectional A* with the same averaged potential as BidirectionalAStarSearch(), kept going
+  // until the two open list minimums add up to the stretch limit instead of the best distance.
+  // The keys of a node in both directions add up to the cost of the route through it, so this
+  // settles the via nodes near the middle of the route in both directions, where good
+  // alternatives branch off, without exploring everything within the stretch limit.
+  auto potential = [&](int v) { return 0.5f * (GraphHValue(v, target) - GraphHValue(source, v)); };
+  GraphQueue forward_queue{stats};
+  GraphQueue backward_queue{stats};
+  forward_space.Reach(source, 0.0f, -1);
+  forward_queue.emplace(potential(source), source);
+  backward_space.Reach(target, 0.0f, -1);
+  backward_queue.emplace(-potential(target), target);
+  float best = source == target ? 0.0f : std::numeric_limits<float>::infinity();
+  int meeting_node = source == target ? source : -1;
+  std::vector<int> forward_settled;
+  auto drop_settled = [](GraphQueue &queue, const SearchSpace &space) {
+    while (!queue.empty() && space.Settled(queue.top().second)) {
+      queue.pop();
+    }
+  };
+
+  while (true) {
+    drop_settled(forward_queue, forward_space);
+    drop_settled(backward_queue, backward_space);
+    if (forward_queue.empty() || backward_queue.empty() ||
+        forward_queue.top().first + backward_queue.top().first > (1.0f + kMaxStretch) * best) {
+      break;
+    }
+
+    bool forward = forward_queue.top().first <= backward_queue.top().first;
+    GraphQueue &queue = forward ? forward_queue : backward_queue;
+    SearchSpace &space = forward ? forward_space : backward_space;
+    const SearchSpace &other_space = forward ? backward_space : forward_space;
+    const RouteGraph::Adjacency &adjacency = forward ? graph.Forward() : graph.Backward();
+    const float sign = forward ? 1.0f : -1.0f;
+
+    int u = queue.top().second;
+    queue.pop();
+    space.Settle(u);
+    stats.settled_nodes++;
+    if (trace) {
+      trace->Record(u, !forward);
+    }
+    if (forward) {
+      forward_settled.push_back(u);
+    }
+    for (int e = adjacency.Begin(u); e < adjacency.End(u); ++e) {
+      stats.relaxed_edges++;
+      int v = adjacency.head[e];
+      float g_value = space.Distance(u) + cost.EdgeCost(adjacency, e);
+      if (g_value < space.Distance(v)) {
+        space.Reach(v, g_value, u);
+        queue.emplace(g_value + sign * potential(v), v);
+        if (other_space.Reached(v) && g_value + other_space.Distance(v) < best) {
+          best = g_value + other_space.Distance(v);
+          meeting_node = v;
+        }
+      }
+    }
+  }
+
+  std::vector<Route> routes;
+  if (meeting_node == -1) {
+    return routes;
+  }
+  // Shortest route through v: forward tree from the source, backward tree to the target.
+  auto via_path = [&](int v) {
+    std::vector<int> path;
+    for (int x = v; x != -1; x = forward_space.Parent(x)) {
+      path.push_back(x);
+    }
+    std::reverse(path.begin(), path.end());
+    for (int x = backward_space.Parent(v); x != -1; x = backward_space.Parent(x)) {
+      path.push_back(x);
+    }
+    return path;
+  };
+  auto edge_cost = [&](int tail, int head) {
+    const RouteGraph::Adjacency &edges = graph.Forward();
+    for (int e = edges.Begin(tail); e < edges.End(tail); ++e) {
+      if (edges.head[e] == head) {
+        return cost.EdgeCost(edges, e);
+      }
+    }
+    return std::numeric_limits<float>::infinity();
+  };
+
+  m_Model.path = via_path(meeting_node);
+  route_cost = best;
+  distance = PathLength(m_Model.path);
+  routes.push_back({route_cost, distance, m_Model.path});
+
+  std::unordered_set<std::uint64_t> chosen_edges;
+  for (std::size_t i = 1; i < m_Model.path.size(); ++i) {
+    chosen_edges.insert(EdgeKey(m_Model.path[i - 1], m_Model.path[i]));
+  }
+
+  // Via nodes in order of the cost of their route. Many via nodes share one route, so nodes on
+  // routes already examined are skipped.
+  std::vector<std::pair<float, int>> candidates;
+  for (int v : forward_settled) {
+    if (backward_space.Settled(v)) {
+      float via_cost = forward_space.Distance(v) + backward_space.Distance(v);
+      if (via_cost <= (1.0f + kMaxStretch) * best) {
+        candidates.emplace_back(via_cost, v);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+  std::unordered_set<int> examined(m_Model.path.begin(), m_Model.path.end());
+  int examined_routes = 0;
+  for (const auto &[via_cost, v] : candidates) {
+    if (static_cast<int>(routes.size()) > max_alternatives || examined_routes == kMaxCandidates) {
+      break;
+    }
+    // Both trees reaching v from the same node means the route turns around at v.
+    if (examined.count(v) || forward_space.Parent(v) == backward_space.Parent(v)) {
+      continue;
+    }
+    ++examined_routes;
+    std::vector<int> path = via_path(v);
+    examined.insert(path.begin(), path.end());
+    std::vector<int> sorted_path = path;
+    std::sort(sorted_path.begin(), sorted_path.end());
+    if (std::adjacent_find(sorted_path.begin(), sorted_path.end()) != sorted_path.end()) {
+      continue;
+    }
+
+    float shared = 0.0f;
+    for (std::size_t i = 1; i < path.size(); ++i) {
+      if (chosen_edges.count(EdgeKey(path[i - 1], path[i]))) {
+        shared += edge_cost(path[i - 1], path[i]);
+      }
+    }
+    if (shared > kMaxSharing * best) {
+      continue;
+    }
+
+    // Local optimality: the part of the route within kLocalOptimality * best on either side of
+    // v must itself be a shortest path, or the route makes a pointless detour around v.
+    const float reach = kLocalOptimality * best;
+    int before = v;
+    while (forward_space.Parent(before) != -1 && forward_space.Distance(v) - forward_space.Distance(before) < reach) {
+      before = forward_space.Parent(before);
+    }
+    int after = v;
+    while (backward_space.Parent(after) != -1 && backward_space.Distance(v) - backward_space.Distance(after) < reach) {
+      after = backward_space.Parent(after);
+    }
+    float section = forward_space.Distance(v) - forward_space.Distance(before) +
+                    backward_space.Distance(v) - backward_space.Distance(after);
+    if (BoundedCost(before, after, section) < section * (1.0f - 1e-4f)) {
+      continue;
+    }
+
+    for (std::size_t i = 1; i < path.size(); ++i) {
+      chosen_edges.insert(EdgeKey(path[i - 1], path[i]));
+    }
+    float length = PathLength(path);
+    routes.push_back({via_cost, length, std::move(path)});
+  }
+  return routes;
+}
+
+template class BasicRoutePlanner<DistanceCost>;
+template class BasicRoutePlanner<TravelTimeCost>;
+template class BasicRoutePlanner<CustomCost>;
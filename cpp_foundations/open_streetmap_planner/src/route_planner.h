@@ -4,30 +4,128 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include "contraction_hierarchy.h"
+#include "cost_policy.h"
+#include "landmarks.h"
+#include "overlay.h"
 #include "route_model.h"
+#include "search_space.h"
+#include "search_stats.h"
+#include "search_trace.h"
 
 
-class RoutePlanner {
+// A* route planner over a RouteModel. The road graph searches run on the graph of one travel
+// profile and minimize the edge costs of the Cost policy (see cost_policy.h); the legacy
+// AStarSearch() always plans the shortest car route.
+template <typename Cost>
+class BasicRoutePlanner {
   public:
-    RoutePlanner(RouteModel &model, float start_x, float start_y, float end_x, float end_y);
+    struct Route {
+        float cost;
+        float distance;  // Meters.
+        std::vector<int> path;  // Node indices from start to end.
+    };
+
+    BasicRoutePlanner(RouteModel &model, float start_x, float start_y, float end_x, float end_y, Cost cost = Cost{},
+                      RouteGraph::Profile profile = RouteGraph::Profile::Car);
+    // Start from endpoints that are already snapped, e.g. while the user was still typing. snap_us
+    // is the time the snapping took, reported by Stats() like that of SetEndpoints().
+    BasicRoutePlanner(RouteModel &model, RouteModel::Node &start, RouteModel::Node &end, double snap_us,
+                      Cost cost = Cost{}, RouteGraph::Profile profile = RouteGraph::Profile::Car);
     // Add public variables or methods declarations here.
+    // Length of the last route in meters.
     float GetDistance() const {return distance;}
+    // Cost of the last route in the units of the cost policy, e.g. seconds for TravelTimeCost.
+    float GetCost() const {return route_cost;}
+    // Tighten the straight-line heuristic with landmark lower bounds (ALT). Pass nullptr to go
+    // back to straight-line distances only. The landmarks must outlive their use here and be
+    // built on the graph of the planner's profile.
+    void SetLandmarks(const Landmarks *landmarks);
+    // Snap a new pair of endpoints (in percent) so the planner can be reused for another query.
+    void SetEndpoints(float start_x, float start_y, float end_x, float end_y);
+    // Snap later endpoints only to nodes of the largest strongly connected component, so that
+    // isolated road fragments never leave a query without a route.
+    void SetSnapToLargestComponent(bool enable) {largest_component_only = enable;}
+    // Record the nodes settled by later searches into trace, replacing what an earlier search
+    // recorded. Pass nullptr to stop recording. The trace must outlive its use here.
+    void SetTrace(SearchTrace *trace) {this->trace = trace;}
     void AStarSearch();
+    // A* over the road graph of the model, searching forward from the start node only.
+    void GraphAStarSearch();
+    // A* over the road graph with a forward and a backward frontier that meet in the middle.
+    // It finds a route of the same cost as GraphAStarSearch() while settling fewer nodes.
+    void BidirectionalAStarSearch();
+    // Edge-based A* over the road graph that honors the turn restrictions of the map and adds
+    // the turn costs set with SetTurnCosts(). It settles road graph edges instead of nodes, so
+    // expect about twice the work of GraphAStarSearch().
+    void TurnAwareSearch();
+    void SetTurnCosts(const TurnCosts &turn_costs) {this->turn_costs = turn_costs;}
+    // Upward bidirectional search in a contraction hierarchy built for the model's road graph.
+    // The hierarchy is built on distances, so the cost is the distance for any policy.
+    void ContractionHierarchySearch(const ContractionHierarchy &hierarchy);
+    // Search on a customizable overlay. The cost is in the units of its current weights.
+    void OverlaySearch(const Overlay &overlay);
+    // The optimal route followed by up to max_alternatives meaningfully different ones, found
+    // with via nodes of one bidirectional A* search. An alternative goes through a node
+    // settled by both directions, costs at most 25% more than the optimal route, shares at most
+    // 80% of its cost with the routes before it and has no shortcut around its via node within
+    // 25% of the optimal cost. The optimal route also becomes the model's path.
+    std::vector<Route> AlternativeRoutes(int max_alternatives = 2);
+    // Number of nodes taken off the open list(s) by the last search.
+    int SettledNodes() const {return stats.settled_nodes;}
+    // Work done by the last search, with the time taken to snap its endpoints.
+    const SearchStats &Stats() const {return stats;}
 
     // The following methods have been made public so we can test them individually.
     void AddNeighbors(RouteModel::Node *current_node);
     float CalculateHValue(RouteModel::Node const *node);
-    std::vector<RouteModel::Node> ConstructFinalPath(RouteModel::Node *);
+    // Node indices from the start node to the given node, following parent pointers.
+    std::vector<int> ConstructFinalPath(RouteModel::Node *);
     RouteModel::Node *NextNode();
 
   private:
     // Add private variables or methods declarations here.
+    // Shared by the public constructors, which then set the endpoints.
+    BasicRoutePlanner(RouteModel &model, Cost cost, RouteGraph::Profile profile);
+    float GraphHValue(int from, int to) const;
+    float PathLength(const std::vector<int> &path) const;
+    // Cost of the cheapest route from one node to another, or any value of at least limit.
+    float BoundedCost(int from, int to, float limit);
+    // Zero the counters and the trace of a new search, keeping the snapping time of its endpoints.
+    void ResetStats();
+    // Trace the settled nodes of a search run elsewhere, in the order of their distance.
+    void TraceSettled(const SearchSpace &space, bool backward);
+
     std::vector<RouteModel::Node*> open_list;
     RouteModel::Node *start_node;
     RouteModel::Node *end_node;
 
     float distance = 0.0f;
+    float route_cost = 0.0f;
+    Cost cost;
+    RouteGraph::Profile profile;
+    bool largest_component_only = false;
+    SearchStats stats;
+    const Landmarks *landmarks = nullptr;
+    SearchTrace *trace = nullptr;
+    TurnCosts turn_costs;
     RouteModel &m_Model;
+    const RouteGraph &m_Graph;
+    SearchSpace forward_space;
+    SearchSpace backward_space;
+    SearchSpace local_space;
+    // Indexed by road graph edge, for TurnAwareSearch().
+    SearchSpace edge_space;
 };
 
+// Shortest routes, as used throughout the project.
+using RoutePlanner = BasicRoutePlanner<DistanceCost>;
+// Fastest routes by road-type speeds.
+using FastestRoutePlanner = BasicRoutePlanner<TravelTimeCost>;
+
+// Instantiated once in route_planner.cpp.
+extern template class BasicRoutePlanner<DistanceCost>;
+extern template class BasicRoutePlanner<TravelTimeCost>;
+extern template class BasicRoutePlanner<CustomCost>;
+
 #endif
\ No newline at end of file
@@ -0,0 +1,579 @@
+#include "route_server.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// Requests a connection may have with the workers at once. Further frames wait in its input
+// buffer and the connection is not read until some are answered, which pushes back on clients
+// that send faster than the workers search.
+constexpr int kMaxPendingPerConnection = 256;
+constexpr std::size_t kReadChunk = 64 * 1024;
+// Length, id and type.
+constexpr std::size_t kHeaderBytes = 9;
+constexpr std::uint32_t kMaxFrameBytes = 1u << 30;
+
+template <typename T>
+void Append(std::vector<std::byte> &buffer, T value) {
+    const auto *bytes = reinterpret_cast<const std::byte *>(&value);
+    buffer.insert(buffer.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+T Take(const std::byte *&data) {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    data += sizeof(value);
+    return value;
+}
+
+bool SetNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// Writes the frame length once the rest of the frame was appended after it.
+void PatchLength(std::vector<std::byte> &buffer, std::size_t frame_start) {
+    const std::uint32_t length = buffer.size() - frame_start - sizeof(std::uint32_t);
+    std::memcpy(buffer.data() + frame_start, &length, sizeof(length));
+}
+
+int ThreadCount(int thread_count) {
+    return thread_count > 0 ? thread_count : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+}  // namespace
+
+RouteServer::RouteServer(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count) :
+    m_Store(ThreadCount(thread_count)), m_Pool(std::make_unique<ThreadPool>(ThreadCount(thread_count))) {
+    auto version = std::make_unique<RouteModelStore::Version>();
+    version->model = &model;
+    version->hierarchy = &hierarchy;
+    m_Store.Publish(std::move(version));
+    m_Epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_Wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_Wakeup;
+    epoll_ctl(m_Epoll, EPOLL_CTL_ADD, m_Wakeup, &event);
+}
+
+RouteServer::~RouteServer() {
+    m_Pool.reset();
+    if (m_Reloader.joinable()) {
+        m_Reloader.join();
+    }
+    for (auto &[fd, connection] : m_Connections) {
+        close(fd);
+    }
+    if (m_Listener != -1) {
+        close(m_Listener);
+    }
+    if (!m_SocketPath.empty()) {
+        unlink(m_SocketPath.c_str());
+    }
+    close(m_Wakeup);
+    close(m_Epoll);
+}
+
+bool RouteServer::ListenUnix(const std::string &path) {
+    sockaddr_un address{};
+    if (m_Listener != -1 || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if (fd == -1 || bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return false;
+    }
+    m_SocketPath = path;
+    return Listen(fd);
+}
+
+bool RouteServer::ListenTcp(int port) {
+    if (m_Listener != -1) {
+        return false;
+    }
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    if (fd == -1 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1 ||
+        bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1) {
+        if (fd != -1) {
+            close(fd);
+        }
+        return false;
+    }
+    socklen_t length = sizeof(address);
+    getsockname(fd, reinterpret_cast<sockaddr *>(&address), &length);
+    m_Port = ntohs(address.sin_port);
+    return Listen(fd);
+}
+
+bool RouteServer::Listen(int fd) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (listen(fd, SOMAXCONN) == -1 || !SetNonBlocking(fd) || epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+        close(fd);
+        return false;
+    }
+    m_Listener = fd;
+    return true;
+}
+
+void RouteServer::Stop() {
+    m_Stop = true;
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(m_Wakeup, &one, sizeof(one));
+}
+
+void RouteServer::SetMapFiles(const std::string &osm_file, const std::string &ch_file) {
+    m_MapFile = osm_file;
+    m_HierarchyFile = ch_file;
+}
+
+void RouteServer::Reload() {
+    m_ReloadRequested = true;
+    std::uint64_t one = 1;
+    [[maybe_unused]] auto written = write(m_Wakeup, &one, sizeof(one));
+}
+
+void RouteServer::StartReload() {
+    if (m_MapFile.empty()) {
+        std::cerr << "No map file to reload." << std::endl;
+        return;
+    }
+    if (m_Reloading) {
+        std::cerr << "Still reloading, ignoring the request." << std::endl;
+        return;
+    }
+    if (m_Reloader.joinable()) {
+        m_Reloader.join();
+    }
+    m_Reloading = true;
+    m_Reloader = std::thread{[this] {
+        // Build at the lowest priority, so the workers keep their cores and latency holds up
+        // while the new model is built.
+        setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+        auto version = RouteModelStore::Load(m_MapFile, m_HierarchyFile);
+        if (!version) {
+            std::cerr << "Failed to reload " << m_MapFile << std::endl;
+            m_Reloading = false;
+            return;
+        }
+        // Start a new cache version for the new model before it is published, so that no query
+        // on either model ever finds routes computed on the other one.
+        if (m_Cache) {
+            m_Cache->Invalidate();
+            version->cache_version = m_Cache->Version();
+        }
+        const auto number = m_Store.Publish(std::move(version));
+        std::cerr << "Serving model version " << number << "." << std::endl;
+        // Free the old model here once the queries still on it are done, not on a worker.
+        while (!m_Store.Reclaim()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        m_Reloading = false;
+    }};
+}
+
+void RouteServer::Run() {
+    std::vector<epoll_event> events(256);
+    while (!m_Stop) {
+        int count = epoll_wait(m_Epoll, events.data(), static_cast<int>(events.size()), -1);
+        if (count == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "epoll_wait failed: " << std::strerror(errno) << std::endl;
+            return;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_Wakeup) {
+                std::uint64_t value;
+                [[maybe_unused]] auto read_bytes = read(m_Wakeup, &value, sizeof(value));
+                if (m_ReloadRequested.exchange(false)) {
+                    StartReload();
+                }
+                DrainCompletions();
+                continue;
+            }
+            if (fd == m_Listener) {
+                Accept();
+                continue;
+            }
+            auto it = m_Connections.find(fd);
+            if (it == m_Connections.end()) {
+                continue;
+            }
+            Connection &connection = it->second;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                Read(connection);
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                // Nothing can be written any more; wait for the workers and close.
+                connection.peer_closed = true;
+                connection.reading = false;
+                connection.hung_up = true;
+                connection.out.clear();
+                connection.out_offset = 0;
+            }
+            else if (events[i].events & EPOLLOUT) {
+                Write(connection);
+            }
+            Update(connection);
+        }
+    }
+}
+
+void RouteServer::Accept() {
+    while (true) {
+        int fd = accept4(m_Listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd == -1) {
+            return;
+        }
+        int no_delay = 1;
+        // Fails harmlessly on Unix domain sockets.
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(m_Epoll, EPOLL_CTL_ADD, fd, &event) == -1) {
+            close(fd);
+            continue;
+        }
+        Connection &connection = m_Connections[fd];
+        connection.fd = fd;
+        connection.id = m_NextConnection++;
+    }
+}
+
+void RouteServer::Read(Connection &connection) {
+    while (connection.reading) {
+        const std::size_t size = connection.in.size();
+        connection.in.resize(size + kReadChunk);
+        ssize_t received = read(connection.fd, connection.in.data() + size, kReadChunk);
+        const int error = errno;
+        connection.in.resize(size + std::max<ssize_t>(received, 0));
+        if (received > 0) {
+            Dispatch(connection);
+            continue;
+        }
+        if (received == -1 && error == EINTR) {
+            continue;
+        }
+        if (received == 0 || (error != EAGAIN && error != EWOULDBLOCK)) {
+            connection.peer_closed = true;
+            connection.reading = false;
+        }
+        return;
+    }
+}
+
+void RouteServer::Dispatch(Connection &connection) {
+    std::size_t offset = 0;
+    while (connection.pending < kMaxPendingPerConnection) {
+        Request request;
+        long size = ParseRequest(connection.in.data() + offset, connection.in.size() - offset, request);
+        if (size == 0) {
+            break;
+        }
+        if (size < 0) {
+            // Nothing after a malformed frame can be trusted.
+            connection.peer_closed = true;
+            connection.in.clear();
+            offset = 0;
+            break;
+        }
+        offset += size;
+        connection.pending++;
+        m_Pool->Submit([this, request, fd = connection.fd, id = connection.id](int worker) {
+            Completion completion{fd, id, {}};
+            AppendResponse(completion.frame, Answer(request, worker));
+            {
+                std::lock_guard<std::mutex> lock{m_CompletionMutex};
+                m_Completions.push_back(std::move(completion));
+            }
+            std::uint64_t one = 1;
+            [[maybe_unused]] auto written = write(m_Wakeup, &one, sizeof(one));
+        });
+    }
+    connection.in.erase(connection.in.begin(), connection.in.begin() + offset);
+    // Stop reading while the workers are busy with this connection's requests.
+    connection.reading = !connection.peer_closed && connection.pending < kMaxPendingPerConnection;
+}
+
+void RouteServer::DrainCompletions() {
+    std::vector<Completion> completions;
+    {
+        std::lock_guard<std::mutex> lock{m_CompletionMutex};
+        completions.swap(m_Completions);
+    }
+    std::vector<int> touched;
+    for (Completion &completion : completions) {
+        auto it = m_Connections.find(completion.fd);
+        // The connection may have been closed, and its descriptor reused, since.
+        if (it == m_Connections.end() || it->second.id != completion.connection) {
+            continue;
+        }
+        Connection &connection = it->second;
+        connection.pending--;
+        connection.out.insert(connection.out.end(), completion.frame.begin(), completion.frame.end());
+        touched.push_back(completion.fd);
+    }
+    std::sort(touched.begin(), touched.end());
+    touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+    for (int fd : touched) {
+        Connection &connection = m_Connections[fd];
+        Write(connection);
+        if (!connection.hung_up) {
+            // Frames held back by the pipelining limit can go to the workers now, also those a
+            // client sent before shutting down its side of the connection.
+            Dispatch(connection);
+            if (connection.reading) {
+                Read(connection);
+            }
+        }
+        Update(connection);
+    }
+}
+
+void RouteServer::Write(Connection &connection) {
+    while (connection.out_offset < connection.out.size()) {
+        ssize_t sent = send(connection.fd, connection.out.data() + connection.out_offset,
+                            connection.out.size() - connection.out_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection.out_offset += sent;
+            continue;
+        }
+        if (sent == -1 && errno == EINTR) {
+            continue;
+        }
+        if (sent == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            // The peer is gone, its responses can be dropped.
+            connection.peer_closed = true;
+            connection.reading = false;
+            connection.out.clear();
+            connection.out_offset = 0;
+        }
+        return;
+    }
+    connection.out.clear();
+    connection.out_offset = 0;
+}
+
+void RouteServer::Update(Connection &connection) {
+    const bool writing = connection.out_offset < connection.out.size();
+    if (connection.peer_closed && connection.pending == 0 && !writing) {
+        Close(connection);
+        return;
+    }
+    if (connection.hung_up) {
+        epoll_ctl(m_Epoll, EPOLL_CTL_DEL, connection.fd, nullptr);
+        return;
+    }
+    epoll_event event{};
+    if (connection.reading) {
+        event.events |= EPOLLIN;
+    }
+    if (writing) {
+        event.events |= EPOLLOUT;
+    }
+    event.data.fd = connection.fd;
+    epoll_ctl(m_Epoll, EPOLL_CTL_MOD, connection.fd, &event);
+}
+
+void RouteServer::Close(Connection &connection) {
+    const int fd = connection.fd;
+    epoll_ctl(m_Epoll, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    m_Connections.erase(fd);
+}
+
+RouteServer::Response RouteServer::Answer(const Request &request, int worker) {
+    Response response;
+    response.id = request.id;
+    response.type = request.type;
+    // The version stays pinned for the whole query, even if a reload publishes a new one.
+    auto version = m_Store.Read(worker);
+    RouteModel &model = *version->model;
+    const ContractionHierarchy &hierarchy = *version->hierarchy;
+    SearchSpace &forward = version->forward[worker];
+    SearchSpace &backward = version->backward[worker];
+    const RouteModel::Node &start = model.FindClosestNode(request.start_x * 0.01f, request.start_y * 0.01f);
+    if (request.type == Type::Snap) {
+        response.node = start.Index();
+        response.x = start.x;
+        response.y = start.y;
+        return response;
+    }
+    const int source = start.Index();
+    const int target = model.FindClosestNode(request.end_x * 0.01f, request.end_y * 0.01f).Index();
+    if (m_Cache) {
+        if (auto route = m_Cache->Find(source, target, version->cache_version)) {
+            if (route->path.empty()) {
+                response.status = Status::NoRoute;
+            }
+            response.distance = route->distance;
+            if (request.type == Type::Route) {
+                response.path = route->path;
+            }
+            return response;
+        }
+    }
+    auto search = hierarchy.Search(source, target, forward, backward);
+    // With a cache the path is unpacked for distance requests too, so later route requests
+    // between the same nodes hit.
+    if (search.meeting_node != -1 && (request.type == Type::Route || m_Cache)) {
+        response.path = hierarchy.UnpackPath(search, forward, backward);
+    }
+    if (m_Cache) {
+        m_Cache->Insert(source, target, search.distance, response.path, version->cache_version);
+    }
+    if (search.meeting_node == -1) {
+        response.status = Status::NoRoute;
+        return response;
+    }
+    response.distance = search.distance;
+    if (request.type != Type::Route) {
+        response.path.clear();
+    }
+    return response;
+}
+
+void RouteServer::AppendRequest(std::vector<std::byte> &buffer, const Request &request) {
+    const std::size_t start = buffer.size();
+    Append<std::uint32_t>(buffer, 0);
+    Append<std::uint32_t>(buffer, request.id);
+    Append<std::uint8_t>(buffer, static_cast<std::uint8_t>(request.type));
+    Append<float>(buffer, request.start_x);
+    Append<float>(buffer, request.start_y);
+    if (request.type != Type::Snap) {
+        Append<float>(buffer, request.end_x);
+        Append<float>(buffer, request.end_y);
+    }
+    PatchLength(buffer, start);
+}
+
+void RouteServer::AppendResponse(std::vector<std::byte> &buffer, const Response &response) {
+    const std::size_t start = buffer.size();
+    Append<std::uint32_t>(buffer, 0);
+    Append<std::uint32_t>(buffer, response.id);
+    Append<std::uint8_t>(buffer, static_cast<std::uint8_t>(response.type));
+    Append<std::uint8_t>(buffer, static_cast<std::uint8_t>(response.status));
+    if (response.type == Type::Snap) {
+        Append<std::int32_t>(buffer, response.node);
+        Append<float>(buffer, response.x);
+        Append<float>(buffer, response.y);
+    }
+    else {
+        Append<float>(buffer, response.distance);
+    }
+    if (response.type == Type::Route) {
+        Append<std::uint32_t>(buffer, response.path.size());
+        for (int node : response.path) {
+            Append<std::int32_t>(buffer, node);
+        }
+    }
+    PatchLength(buffer, start);
+}
+
+long RouteServer::ParseRequest(const std::byte *data, std::size_t size, Request &request) {
+    if (size < kHeaderBytes) {
+        return 0;
+    }
+    const std::byte *p = data;
+    const auto length = Take<std::uint32_t>(p);
+    request.id = Take<std::uint32_t>(p);
+    request.type = static_cast<Type>(Take<std::uint8_t>(p));
+    const std::uint32_t expected = request.type == Type::Snap ? 13 : 21;
+    if ((request.type != Type::Route && request.type != Type::Distance && request.type != Type::Snap) ||
+        length != expected) {
+        return -1;
+    }
+    if (size < sizeof(length) + length) {
+        return 0;
+    }
+    request.start_x = Take<float>(p);
+    request.start_y = Take<float>(p);
+    if (request.type != Type::Snap) {
+        request.end_x = Take<float>(p);
+        request.end_y = Take<float>(p);
+    }
+    return static_cast<long>(sizeof(length) + length);
+}
+
+long RouteServer::ParseResponse(const std::byte *data, std::size_t size, Response &response) {
+    if (size < kHeaderBytes + 1) {
+        return 0;
+    }
+    const std::byte *p = data;
+    const auto length = Take<std::uint32_t>(p);
+    if (length > kMaxFrameBytes) {
+        return -1;
+    }
+    if (size < sizeof(length) + length) {
+        return 0;
+    }
+    const std::byte *end = data + sizeof(length) + length;
+    response.id = Take<std::uint32_t>(p);
+    response.type = static_cast<Type>(Take<std::uint8_t>(p));
+    response.status = static_cast<Status>(Take<std::uint8_t>(p));
+    response.path.clear();
+    if (response.type == Type::Snap) {
+        if (end - p != 12) {
+            return -1;
+        }
+        response.node = Take<std::int32_t>(p);
+        response.x = Take<float>(p);
+        response.y = Take<float>(p);
+    }
+    else if (response.type == Type::Distance || response.type == Type::Route) {
+        if (end - p < 4) {
+            return -1;
+        }
+        response.distance = Take<float>(p);
+        if (response.type == Type::Route) {
+            if (end - p < 4) {
+                return -1;
+            }
+            const auto count = Take<std::uint32_t>(p);
+            if (static_cast<std::size_t>(end - p) != count * sizeof(std::int32_t)) {
+                return -1;
+            }
+            response.path.resize(count);
+            for (int &node : response.path) {
+                node = Take<std::int32_t>(p);
+            }
+        }
+    }
+    else {
+        return -1;
+    }
+    return static_cast<long>(sizeof(length) + length);
+}
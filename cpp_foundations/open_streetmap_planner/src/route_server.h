@@ -0,0 +1,153 @@
+#ifndef ROUTE_SERVER_H
+#define ROUTE_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "contraction_hierarchy.h"
+#include "route_cache.h"
+#include "route_model.h"
+#include "route_model_store.h"
+#include "thread_pool.h"
+
+// Long running routing daemon. It answers route, distance and snap requests over a Unix domain
+// socket or a TCP port on the loopback interface, so the model is loaded once and not per
+// request. One thread runs an epoll event loop over all connections and hands the searches to
+// a worker pool; every worker owns its own search spaces. The map can be reloaded while the
+// server runs: the new model is built in the background and replaces the old one between
+// queries, see RouteModelStore.
+//
+// Messages are frames of a uint32 length of the rest of the frame, a uint32 request id chosen
+// by the client and a uint8 message type, followed by a response status and the payload, in
+// native byte order since both ends run on one host. A client may send any number of requests
+// without waiting for responses (pipelining). Every response carries the id of its request,
+// and responses can come back in a different order than their requests.
+class RouteServer {
+  public:
+    enum class Type : std::uint8_t { Route = 1, Distance = 2, Snap = 3 };
+    enum class Status : std::uint8_t { Ok = 0, NoRoute = 1 };
+
+    // Payload: four float32 endpoints, or the start only for Snap.
+    struct Request {
+        std::uint32_t id = 0;
+        Type type = Type::Route;
+        float start_x = 0.0f;  // Percent of the map, like the RoutePlanner endpoints.
+        float start_y = 0.0f;
+        float end_x = 0.0f;
+        float end_y = 0.0f;
+    };
+
+    // Payload: Route has a float32 distance, a uint32 node count and the int32 nodes, Distance
+    // the distance only and Snap the int32 node and its float32 x and y in map units.
+    struct Response {
+        std::uint32_t id = 0;
+        Type type = Type::Route;
+        Status status = Status::Ok;
+        float distance = 0.0f;  // Meters.
+        std::vector<int> path;  // Node indices from start to end.
+        int node = -1;
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
+    RouteServer(RouteModel &model, const ContractionHierarchy &hierarchy, int thread_count = 0);
+    ~RouteServer();
+    RouteServer(const RouteServer &) = delete;
+    RouteServer &operator=(const RouteServer &) = delete;
+
+    // Listen on a Unix domain socket, replacing a stale socket file at path.
+    bool ListenUnix(const std::string &path);
+    // Listen on a TCP port of 127.0.0.1. Port 0 picks a free port, see Port().
+    bool ListenTcp(int port);
+    int Port() const { return m_Port; }
+
+    // Map and contraction hierarchy files read by Reload(); call before Run().
+    void SetMapFiles(const std::string &osm_file, const std::string &ch_file = "");
+    // Read the map files again and switch to the new model once it is built, while the current
+    // one keeps answering. May be called from any thread, e.g. a signal handling one. Ignored
+    // while a reload is still running.
+    void Reload();
+    // Number of the model version new requests are answered on, counting from 1.
+    std::uint64_t ModelVersion() const { return m_Store.CurrentVersion(); }
+    bool Reloading() const { return m_Reloading; }
+    // Answer repeated route and distance requests from cache; call before Run() with a cache no
+    // one else uses. Every reload invalidates it. The cache must outlive the server.
+    void SetCache(RouteCache *cache) { m_Cache = cache; }
+
+    // Serve on the calling thread until Stop(). Searches still running then finish when the
+    // server is destroyed, and their responses are dropped.
+    void Run();
+    // May be called from any thread, e.g. a signal handling one.
+    void Stop();
+
+    // Search for one request on the search spaces of a worker.
+    Response Answer(const Request &request, int worker);
+
+    // Frames of the protocol, for clients such as the load generator.
+    static void AppendRequest(std::vector<std::byte> &buffer, const Request &request);
+    static void AppendResponse(std::vector<std::byte> &buffer, const Response &response);
+    // Parse the frame at the start of data. Returns its size in bytes, 0 while it is incomplete
+    // or -1 if it is malformed.
+    static long ParseRequest(const std::byte *data, std::size_t size, Request &request);
+    static long ParseResponse(const std::byte *data, std::size_t size, Response &response);
+
+  private:
+    struct Connection {
+        int fd = -1;
+        std::uint64_t id = 0;
+        std::vector<std::byte> in;
+        std::vector<std::byte> out;
+        std::size_t out_offset = 0;
+        int pending = 0;  // Requests handed to the workers and not answered yet.
+        bool reading = true;
+        bool peer_closed = false;
+        bool hung_up = false;  // Out of epoll, as a hung up socket would be reported forever.
+    };
+    struct Completion {
+        int fd;
+        std::uint64_t connection;
+        std::vector<std::byte> frame;
+    };
+
+    bool Listen(int fd);
+    void Accept();
+    void Read(Connection &connection);
+    void Write(Connection &connection);
+    // Hand the complete frames of the input buffer to the workers, up to the pipelining limit.
+    void Dispatch(Connection &connection);
+    void DrainCompletions();
+    // Watch for input only while the connection takes more requests, and for output while
+    // responses wait to be written. Closes the connection once it has nothing left to do.
+    void Update(Connection &connection);
+    void Close(Connection &connection);
+    // Build the next model version on m_Reloader, publish it and free the old one.
+    void StartReload();
+
+    RouteModelStore m_Store;
+    std::string m_MapFile;
+    std::string m_HierarchyFile;
+    std::atomic<bool> m_ReloadRequested{false};
+    std::atomic<bool> m_Reloading{false};
+    RouteCache *m_Cache = nullptr;
+    std::thread m_Reloader;
+    int m_Epoll = -1;
+    int m_Listener = -1;
+    int m_Wakeup = -1;  // eventfd signalled by Stop(), Reload() and by workers with completions.
+    int m_Port = 0;
+    std::string m_SocketPath;
+    std::atomic<bool> m_Stop{false};
+    std::unordered_map<int, Connection> m_Connections;
+    std::uint64_t m_NextConnection = 1;
+    std::mutex m_CompletionMutex;
+    std::vector<Completion> m_Completions;
+    // Reset first by the destructor, so the workers finish before the state they use goes.
+    std::unique_ptr<ThreadPool> m_Pool;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SEARCH_SPACE_H
+#define SEARCH_SPACE_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+// Tentative distances and parents of one search direction over a RouteGraph. Entries are
+// stamped with a generation so Clear() is O(1) and a search space can be reused per query.
+class SearchSpace {
+  public:
+    SearchSpace(int node_count = 0) : m_Distance(node_count), m_Parent(node_count), m_Stamp(node_count, 0) {}
+
+    void Clear() {
+        m_Generation += 2;
+        if (m_Generation < 2) {
+            // The counter wrapped, so old stamps could look current again.
+            std::fill(m_Stamp.begin(), m_Stamp.end(), 0);
+            m_Generation = 2;
+        }
+    }
+
+    bool Reached(int v) const { return m_Stamp[v] >= m_Generation; }
+    bool Settled(int v) const { return m_Stamp[v] == m_Generation + 1; }
+    float Distance(int v) const { return Reached(v) ? m_Distance[v] : std::numeric_limits<float>::infinity(); }
+    int Parent(int v) const { return Reached(v) ? m_Parent[v] : -1; }
+
+    void Reach(int v, float distance, int parent) {
+        m_Distance[v] = distance;
+        m_Parent[v] = parent;
+        m_Stamp[v] = m_Generation;
+    }
+    void Settle(int v) { m_Stamp[v] = m_Generation + 1; }
+
+  private:
+    std::vector<float> m_Distance;
+    std::vector<int> m_Parent;
+    // m_Generation marks reached nodes and m_Generation + 1 settled ones.
+    std::vector<unsigned int> m_Stamp;
+    unsigned int m_Generation = 2;
+};
+
+#endif
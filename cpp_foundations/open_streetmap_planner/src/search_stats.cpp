@@ -0,0 +1,79 @@
+#include "search_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+void SearchStatsHistogram::Add(const SearchStats &stats) {
+    const std::array<double, kMetricCount> values{
+        static_cast<double>(stats.settled_nodes), static_cast<double>(stats.relaxed_edges),
+        static_cast<double>(stats.heap_pushes), static_cast<double>(stats.heap_pops),
+        static_cast<double>(stats.max_open_list), stats.snap_us, stats.search_us};
+    for (int metric = 0; metric < kMetricCount; ++metric) {
+        ++m_Buckets[metric][Bucket(values[metric])];
+        m_Sum[metric] += values[metric];
+        m_Max[metric] = std::max(m_Max[metric], values[metric]);
+    }
+    ++m_Count;
+}
+
+void SearchStatsHistogram::Merge(const SearchStatsHistogram &other) {
+    for (int metric = 0; metric < kMetricCount; ++metric) {
+        for (int b = 0; b < kBucketCount; ++b) {
+            m_Buckets[metric][b] += other.m_Buckets[metric][b];
+        }
+        m_Sum[metric] += other.m_Sum[metric];
+        m_Max[metric] = std::max(m_Max[metric], other.m_Max[metric]);
+    }
+    m_Count += other.m_Count;
+}
+
+int SearchStatsHistogram::Bucket(double value) {
+    if (!(value >= 1.0)) {
+        return 0;
+    }
+    const int bucket = 1 + static_cast<int>(std::floor(std::log2(value) * kBucketsPerOctave));
+    return std::min(bucket, kBucketCount - 1);
+}
+
+double SearchStatsHistogram::Percentile(Metric metric, double fraction) const {
+    if (m_Count == 0) {
+        return 0.0;
+    }
+    // Rank of the query at the fraction, counting from 1.
+    const auto rank = std::max<std::int64_t>(1, static_cast<std::int64_t>(std::ceil(fraction * m_Count)));
+    std::int64_t seen = 0;
+    for (int b = 0; b < kBucketCount; ++b) {
+        seen += m_Buckets[metric][b];
+        if (seen >= rank) {
+            const double upper = b == 0 ? 1.0 : std::exp2(static_cast<double>(b) / kBucketsPerOctave);
+            return std::min(upper, m_Max[metric]);
+        }
+    }
+    return m_Max[metric];
+}
+
+void SearchStatsHistogram::Print(std::ostream &os) const {
+    os << m_Count << " queries\n";
+    os << std::left << std::setw(16) << "metric" << std::right << std::setw(12) << "mean" << std::setw(12) << "p50"
+       << std::setw(12) << "p90" << std::setw(12) << "p99" << std::setw(12) << "max" << '\n';
+    for (int m = 0; m < kMetricCount; ++m) {
+        const auto metric = static_cast<Metric>(m);
+        os << std::left << std::setw(16) << Name(metric) << std::right << std::fixed << std::setprecision(1)
+           << std::setw(12) << Mean(metric) << std::setw(12) << Percentile(metric, 0.5) << std::setw(12)
+           << Percentile(metric, 0.9) << std::setw(12) << Percentile(metric, 0.99) << std::setw(12) << Max(metric) << '\n';
+    }
+    os << std::defaultfloat;
+}
+
+const char *SearchStatsHistogram::Name(Metric metric) {
+    switch (metric) {
+        case SettledNodes: return "settled_nodes";
+        case RelaxedEdges: return "relaxed_edges";
+        case HeapPushes: return "heap_pushes";
+        case HeapPops: return "heap_pops";
+        case MaxOpenList: return "max_open_list";
+        case SnapUs: return "snap_us";
+        case SearchUs: return "search_us";
+        default: return "unknown";
+    }
+}
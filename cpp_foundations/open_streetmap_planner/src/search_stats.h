@@ -0,0 +1,66 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+// Work done by one route query. Searches that run inside a contraction hierarchy or overlay only
+// report the settled nodes and the times.
+struct SearchStats {
+    int settled_nodes = 0;
+    std::int64_t relaxed_edges = 0;
+    std::int64_t heap_pushes = 0;
+    std::int64_t heap_pops = 0;
+    int max_open_list = 0;  // Most entries in one open list at once, stale ones included.
+    double snap_us = 0.0;  // Snapping the endpoints to the road graph.
+    double search_us = 0.0;
+};
+
+// Distribution of every SearchStats field over many queries, e.g. a batch or a day of traffic.
+// Values are counted in quarter-octave buckets, so percentiles are within 19% of the exact
+// value and a histogram takes the same memory however many queries it sees. Histograms of
+// separate workers can be merged.
+class SearchStatsHistogram {
+  public:
+    enum Metric { SettledNodes, RelaxedEdges, HeapPushes, HeapPops, MaxOpenList, SnapUs, SearchUs, kMetricCount };
+
+    void Add(const SearchStats &stats);
+    void Merge(const SearchStatsHistogram &other);
+
+    std::int64_t Count() const { return m_Count; }
+    double Mean(Metric metric) const { return m_Count ? m_Sum[metric] / m_Count : 0.0; }
+    double Max(Metric metric) const { return m_Max[metric]; }
+    // Upper bound of the bucket that holds the given fraction of the queries, capped at Max().
+    double Percentile(Metric metric, double fraction) const;
+    // One line per metric with the mean, p50, p90, p99 and max.
+    void Print(std::ostream &os) const;
+    static const char *Name(Metric metric);
+
+  private:
+    // Bucket 0 holds values below 1, bucket b > 0 holds [2^((b - 1) / 4), 2^(b / 4)).
+    static constexpr int kBucketsPerOctave = 4;
+    static constexpr int kBucketCount = 1 + 48 * kBucketsPerOctave;
+    static int Bucket(double value);
+
+    std::array<std::array<std::int64_t, kBucketCount>, kMetricCount> m_Buckets{};
+    std::array<double, kMetricCount> m_Sum{};
+    std::array<double, kMetricCount> m_Max{};
+    std::int64_t m_Count = 0;
+};
+
+// Writes the wall time of a search into its stats when it goes out of scope, so every return
+// path of the search is timed.
+class SearchTimer {
+  public:
+    explicit SearchTimer(double &elapsed_us) : m_Elapsed(elapsed_us), m_Start(Clock::now()) {}
+    ~SearchTimer() { m_Elapsed = std::chrono::duration<double, std::micro>(Clock::now() - m_Start).count(); }
+
+  private:
+    using Clock = std::chrono::steady_clock;
+    double &m_Elapsed;
+    Clock::time_point m_Start;
+};
+
+#endif
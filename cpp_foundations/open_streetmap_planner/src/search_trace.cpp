@@ -0,0 +1,88 @@
+#include "search_trace.h"
+#include <cstdint>
+#include <fstream>
+
+namespace {
+
+constexpr std::uint32_t kFileMagic = 0x5254534f;  // "OSTR"
+constexpr std::int32_t kFileVersion = 1;
+
+void WriteVarint(std::ostream &os, std::uint64_t value) {
+    while (value >= 0x80) {
+        os.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    os.put(static_cast<char>(value));
+}
+
+bool ReadVarint(std::istream &is, std::uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        int byte = is.get();
+        if (byte == std::char_traits<char>::eof()) {
+            return false;
+        }
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+bool SearchTrace::Save(const std::string &path, int node_count) const {
+    std::ofstream os{path, std::ios::binary};
+    if (!os) {
+        return false;
+    }
+    const std::int32_t nodes = node_count;
+    const std::uint32_t size = m_Entries.size();
+    os.write(reinterpret_cast<const char*>(&kFileMagic), sizeof(kFileMagic));
+    os.write(reinterpret_cast<const char*>(&kFileVersion), sizeof(kFileVersion));
+    os.write(reinterpret_cast<const char*>(&nodes), sizeof(nodes));
+    os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    std::int64_t previous = 0;
+    for (const Entry &entry : m_Entries) {
+        const std::int64_t delta = entry.node - previous;
+        const std::uint64_t zigzag = (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+        WriteVarint(os, zigzag << 1 | entry.backward);
+        previous = entry.node;
+    }
+    return static_cast<bool>(os);
+}
+
+std::optional<SearchTrace> SearchTrace::Load(const std::string &path, int node_count) {
+    std::ifstream is{path, std::ios::binary};
+    if (!is) {
+        return std::nullopt;
+    }
+    std::uint32_t magic = 0;
+    std::int32_t version = 0;
+    std::int32_t nodes = 0;
+    std::uint32_t size = 0;
+    is.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    is.read(reinterpret_cast<char*>(&version), sizeof(version));
+    is.read(reinterpret_cast<char*>(&nodes), sizeof(nodes));
+    is.read(reinterpret_cast<char*>(&size), sizeof(size));
+    if (!is || magic != kFileMagic || version != kFileVersion || nodes != node_count) {
+        return std::nullopt;
+    }
+    SearchTrace trace;
+    std::int64_t previous = 0;
+    for (std::uint32_t i = 0; i < size; ++i) {
+        std::uint64_t value = 0;
+        if (!ReadVarint(is, value)) {
+            return std::nullopt;
+        }
+        const std::uint64_t zigzag = value >> 1;
+        const std::int64_t node = previous + static_cast<std::int64_t>((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+        if (node < 0 || node >= node_count) {
+            return std::nullopt;
+        }
+        trace.Record(static_cast<int>(node), value & 1);
+        previous = node;
+    }
+    return trace;
+}
@@ -0,0 +1,34 @@
+#ifndef SEARCH_TRACE_H
+#define SEARCH_TRACE_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// The nodes a search settled, in the order it settled them, to see where a search spends its
+// effort and to compare heuristics and speedup techniques on the same query.
+class SearchTrace {
+  public:
+    struct Entry {
+        int node;
+        bool backward;  // Settled by the backward direction of a bidirectional search.
+    };
+
+    void Clear() { m_Entries.clear(); }
+    void Record(int node, bool backward = false) { m_Entries.push_back({node, backward}); }
+    const std::vector<Entry> &Entries() const { return m_Entries; }
+    int Size() const { return static_cast<int>(m_Entries.size()); }
+
+    // Consecutive settled nodes are usually close in the graph, so entries are stored as
+    // zigzag varints of the difference to the previous node, with the direction in the low bit.
+    // That takes one or two bytes per entry on most maps.
+    bool Save(const std::string &path, int node_count) const;
+    // Load a trace written by Save(). Returns nothing if the file is missing or damaged, or was
+    // recorded on a map with another node count.
+    static std::optional<SearchTrace> Load(const std::string &path, int node_count);
+
+  private:
+    std::vector<Entry> m_Entries;
+};
+
+#endif
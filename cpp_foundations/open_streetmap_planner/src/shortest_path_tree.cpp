@@ -0,0 +1,87 @@
+#include "shortest_path_tree.h"
+#include <algorithm>
+#include <cmath>
+#include "radix_heap.h"
+
+ShortestPathTree::ShortestPathTree(const RouteGraph &graph, int source, float cutoff) :
+    m_Source(source), m_Distance(graph.NodeCount(), kUnreached), m_Parent(graph.NodeCount(), -1) {
+    // Keep one unit below the unreached marker so sums never wrap.
+    const double limit = std::min<double>(std::floor(static_cast<double>(cutoff) * kUnitsPerMeter), kUnreached - 1.0);
+    if (limit < 0.0) {
+        return;
+    }
+    const auto max_distance = static_cast<std::uint64_t>(limit);
+    const auto &edges = graph.Forward();
+
+    RadixHeap heap;
+    m_Distance[source] = 0;
+    heap.Push(0, source);
+    while (!heap.Empty()) {
+        auto [distance, v] = heap.Pop();
+        if (distance > m_Distance[v]) {
+            continue;
+        }
+        m_Nodes.push_back(v);
+        for (int e = edges.Begin(v); e < edges.End(v); ++e) {
+            int w = edges.head[e];
+            auto units = static_cast<std::uint64_t>(std::lround(edges.weight[e] * kUnitsPerMeter));
+            std::uint64_t candidate = distance + units;
+            if (candidate <= max_distance && candidate < m_Distance[w]) {
+                m_Distance[w] = static_cast<std::uint32_t>(candidate);
+                m_Parent[w] = v;
+                heap.Push(m_Distance[w], w);
+            }
+        }
+    }
+}
+
+float ShortestPathTree::Distance(int v) const {
+    return Contains(v) ? m_Distance[v] / kUnitsPerMeter : std::numeric_limits<float>::infinity();
+}
+
+std::vector<int> ShortestPathTree::PathTo(int v) const {
+    std::vector<int> path;
+    if (!Contains(v)) {
+        return path;
+    }
+    for (; v != -1; v = m_Parent[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+// Andrew's monotone chain.
+std::vector<int> ConvexHull(const std::vector<Model::Node> &nodes, std::vector<int> indices) {
+    std::sort(indices.begin(), indices.end(), [&](int a, int b) {
+        return nodes[a].x < nodes[b].x || (nodes[a].x == nodes[b].x && nodes[a].y < nodes[b].y);
+    });
+    indices.erase(std::unique(indices.begin(), indices.end(), [&](int a, int b) {
+        return nodes[a].x == nodes[b].x && nodes[a].y == nodes[b].y;
+    }), indices.end());
+    if (indices.size() < 3) {
+        return indices;
+    }
+
+    auto cross = [&](int o, int a, int b) {
+        return (nodes[a].x - nodes[o].x) * (nodes[b].y - nodes[o].y) -
+               (nodes[a].y - nodes[o].y) * (nodes[b].x - nodes[o].x);
+    };
+    std::vector<int> hull(2 * indices.size());
+    std::size_t k = 0;
+    for (int i : indices) {  // Lower hull.
+        while (k >= 2 && cross(hull[k - 2], hull[k - 1], i) <= 0) {
+            --k;
+        }
+        hull[k++] = i;
+    }
+    for (std::size_t j = indices.size() - 1, lower = k + 1; j-- > 0;) {  // Upper hull.
+        int i = indices[j];
+        while (k >= lower && cross(hull[k - 2], hull[k - 1], i) <= 0) {
+            --k;
+        }
+        hull[k++] = i;
+    }
+    hull.resize(k - 1);  // The last point repeats the first.
+    return hull;
+}
@@ -0,0 +1,48 @@
+#ifndef SHORTEST_PATH_TREE_H
+#define SHORTEST_PATH_TREE_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "model.h"
+#include "route_graph.h"
+
+// Shortest paths from one source to every node within a distance cutoff, found by a single
+// Dijkstra pass over a RouteGraph. Edge weights are rounded to centimeters so the pass can use
+// a radix heap, and nothing beyond the cutoff is ever queued.
+class ShortestPathTree {
+  public:
+    ShortestPathTree(const RouteGraph &graph, int source, float cutoff = std::numeric_limits<float>::infinity());
+
+    int Source() const { return m_Source; }
+    // Whether v is reachable from the source within the cutoff.
+    bool Contains(int v) const { return m_Distance[v] != kUnreached; }
+    // Distance in meters, or infinity if v is not in the tree.
+    float Distance(int v) const;
+    // Previous node on the shortest path to v, or -1 for the source and nodes not in the tree.
+    int Parent(int v) const { return m_Parent[v]; }
+    // Nodes of the tree in order of increasing distance, starting with the source.
+    const std::vector<int> &Nodes() const { return m_Nodes; }
+    // Node indices from the source to v, or an empty path if v is not in the tree.
+    std::vector<int> PathTo(int v) const;
+
+  private:
+    static constexpr float kUnitsPerMeter = 100.0f;
+    static constexpr std::uint32_t kUnreached = std::numeric_limits<std::uint32_t>::max();
+
+    int m_Source;
+    std::vector<std::uint32_t> m_Distance;
+    std::vector<int> m_Parent;
+    std::vector<int> m_Nodes;
+};
+
+// Area reachable from a node within a distance, for display on the map.
+struct Isochrone {
+    std::vector<int> nodes;  // Reachable node indices.
+    std::vector<int> hull;   // Convex hull around them as node indices, counter-clockwise.
+};
+
+// Convex hull of the given nodes, counter-clockwise and without collinear points.
+std::vector<int> ConvexHull(const std::vector<Model::Node> &nodes, std::vector<int> indices);
+
+#endif
@@ -0,0 +1,109 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace {
+// Worker index of the current thread, or -1 outside the pool.
+thread_local int current_worker = -1;
+thread_local const ThreadPool *current_pool = nullptr;
+}  // namespace
+
+ThreadPool::ThreadPool(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        m_Queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        m_Workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock{m_WakeMutex};
+        m_Stop = true;
+    }
+    m_Wake.notify_all();
+    for (auto &worker : m_Workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(Task task) {
+    // Tasks submitted from a worker stay local to it; others are spread round robin.
+    int queue = current_pool == this ? current_worker : static_cast<int>(m_NextQueue++ % m_Queues.size());
+    {
+        std::lock_guard<std::mutex> lock{m_Queues[queue]->mutex};
+        m_Queues[queue]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock{m_WakeMutex};
+        m_Pending++;
+    }
+    m_Wake.notify_one();
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int index, int worker)> &body, int grain) {
+    if (count <= 0) {
+        return;
+    }
+    grain = std::max(1, grain);
+    std::mutex done_mutex;
+    std::condition_variable done;
+    int remaining = (count + grain - 1) / grain;
+    for (int begin = 0; begin < count; begin += grain) {
+        int end = std::min(count, begin + grain);
+        Submit([&, begin, end](int worker) {
+            for (int i = begin; i < end; ++i) {
+                body(i, worker);
+            }
+            std::lock_guard<std::mutex> lock{done_mutex};
+            if (--remaining == 0) {
+                done.notify_all();
+            }
+        });
+    }
+    std::unique_lock<std::mutex> lock{done_mutex};
+    done.wait(lock, [&] { return remaining == 0; });
+}
+
+bool ThreadPool::TryPop(int worker, Task &task) {
+    {
+        WorkQueue &own = *m_Queues[worker];
+        std::lock_guard<std::mutex> lock{own.mutex};
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (std::size_t offset = 1; offset < m_Queues.size(); ++offset) {
+        WorkQueue &victim = *m_Queues[(worker + offset) % m_Queues.size()];
+        std::lock_guard<std::mutex> lock{victim.mutex};
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::WorkerLoop(int worker) {
+    current_worker = worker;
+    current_pool = this;
+    while (true) {
+        Task task;
+        if (TryPop(worker, task)) {
+            m_Pending--;
+            task(worker);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock{m_WakeMutex};
+        m_Wake.wait(lock, [&] { return m_Stop || m_Pending > 0; });
+        if (m_Stop && m_Pending == 0) {
+            return;
+        }
+    }
+}
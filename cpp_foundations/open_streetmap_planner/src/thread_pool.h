@@ -0,0 +1,49 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task deque each. Workers take tasks from the back of
+// their own deque and steal from the front of the others when it runs dry.
+class ThreadPool {
+  public:
+    // A task is called with the index of the worker running it, in [0, Size()).
+    using Task = std::function<void(int worker)>;
+
+    ThreadPool(int thread_count = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int Size() const { return static_cast<int>(m_Workers.size()); }
+    void Submit(Task task);
+    // Run body(index, worker) for every index in [0, count) and wait for all of them. Indices
+    // are handed out in chunks of grain consecutive values. Must not be called from a task.
+    void ParallelFor(int count, const std::function<void(int index, int worker)> &body, int grain = 1);
+
+  private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(int worker);
+    bool TryPop(int worker, Task &task);
+
+    std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+    std::vector<std::thread> m_Workers;
+    std::mutex m_WakeMutex;
+    std::condition_variable m_Wake;
+    std::atomic<int> m_Pending{0};
+    std::atomic<unsigned int> m_NextQueue{0};
+    bool m_Stop = false;
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "turn_table.h"
+#include <cmath>
+
+TurnTable::TurnTable(const Model &model, const RouteGraph &graph) :
+    m_Nodes(model.Nodes()), m_Edges(graph.Forward()), m_Tail(graph.EdgeCount()), m_Restricted(graph.EdgeCount(), false) {
+    for (int v = 0; v < graph.NodeCount(); ++v) {
+        std::fill(m_Tail.begin() + m_Edges.Begin(v), m_Tail.begin() + m_Edges.End(v), v);
+    }
+
+    // Turn restrictions bind vehicles only.
+    if (graph.GetProfile() != RouteGraph::Profile::Car) {
+        return;
+    }
+
+    auto find_edge = [&](int tail, int head) {
+        for (int e = m_Edges.Begin(tail); e < m_Edges.End(tail); ++e) {
+            if (m_Edges.head[e] == head) {
+                return e;
+            }
+        }
+        return -1;
+    };
+    // Neighbors of a node along a way, in both directions in case the way passes through it.
+    auto way_neighbors = [&](int way, int via) {
+        std::vector<int> neighbors;
+        const auto &nodes = model.Ways()[way].nodes;
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            if (nodes[i] != via) {
+                continue;
+            }
+            if (i > 0) {
+                neighbors.push_back(nodes[i - 1]);
+            }
+            if (i + 1 < nodes.size()) {
+                neighbors.push_back(nodes[i + 1]);
+            }
+        }
+        return neighbors;
+    };
+
+    for (const Model::TurnRestriction &restriction : model.TurnRestrictions()) {
+        const int via = restriction.via;
+        const std::vector<int> to_nodes = way_neighbors(restriction.to, via);
+        for (int from_node : way_neighbors(restriction.from, via)) {
+            const int from = find_edge(from_node, via);
+            if (from == -1) {
+                continue;
+            }
+            for (int to = m_Edges.Begin(via); to < m_Edges.End(via); ++to) {
+                const bool onto_to_way = std::find(to_nodes.begin(), to_nodes.end(), m_Edges.head[to]) != to_nodes.end();
+                // A no_* restriction bans the turns onto the to way, an only_* one all others.
+                if (onto_to_way == (restriction.type == Model::TurnRestriction::No)) {
+                    m_Banned.push_back(Key(from, to));
+                    m_Restricted[from] = true;
+                }
+            }
+        }
+    }
+    std::sort(m_Banned.begin(), m_Banned.end());
+    m_Banned.erase(std::unique(m_Banned.begin(), m_Banned.end()), m_Banned.end());
+}
+
+float TurnTable::Cost(int from, int to, const TurnCosts &costs) const {
+    if (!Allowed(from, to)) {
+        return std::numeric_limits<float>::infinity();
+    }
+    const int tail = m_Tail[from];
+    const int via = m_Edges.head[from];
+    const int head = m_Edges.head[to];
+    const int degree = m_Edges.End(via) - m_Edges.Begin(via);
+    if (head == tail) {
+        // A dead end leaves no other way to go on.
+        return degree == 1 && std::isinf(costs.u_turn) ? 0.0f : costs.u_turn;
+    }
+    if (degree <= 2) {
+        // Bends along a single road are not turns.
+        return 0.0f;
+    }
+    const double in_x = m_Nodes[via].x - m_Nodes[tail].x;
+    const double in_y = m_Nodes[via].y - m_Nodes[tail].y;
+    const double out_x = m_Nodes[head].x - m_Nodes[via].x;
+    const double out_y = m_Nodes[head].y - m_Nodes[via].y;
+    const double cross = in_x * out_y - in_y * out_x;
+    const double dot = in_x * out_x + in_y * out_y;
+    if (dot > std::abs(cross)) {
+        // Within 45 degrees of going straight on.
+        return 0.0f;
+    }
+    // North is up, so a counterclockwise turn is a left turn.
+    return cross > 0 ? costs.left : costs.right;
+}
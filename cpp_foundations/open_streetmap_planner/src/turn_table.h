@@ -0,0 +1,50 @@
+#ifndef TURN_TABLE_H
+#define TURN_TABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "model.h"
+#include "route_graph.h"
+
+// Penalties for turning at an intersection, in the units of the cost policy they are used with.
+// A turn is left or right when the road bends by more than 45 degrees. An infinite U-turn cost
+// allows U-turns only at dead ends.
+struct TurnCosts {
+    float left = 0.0f;
+    float right = 0.0f;
+    float u_turn = std::numeric_limits<float>::infinity();
+};
+
+// Turns between the Forward() edges of a RouteGraph, for edge-based searches. The turn
+// restrictions of the model are kept as a sorted list of banned (from edge, to edge) pairs and a
+// flag per edge that has any, so most turns are decided without a lookup. Apart from the tail of
+// every edge, nothing is stored per turn: turn costs come from the node coordinates on the fly.
+class TurnTable {
+  public:
+    TurnTable(const Model &model, const RouteGraph &graph);
+
+    // Node the edge starts at.
+    int Tail(int e) const { return m_Tail[e]; }
+    // Whether a route may continue from edge from onto edge to, which leaves the head of from.
+    bool Allowed(int from, int to) const {
+        return !m_Restricted[from] || !std::binary_search(m_Banned.begin(), m_Banned.end(), Key(from, to));
+    }
+    // Penalty for continuing from edge from onto edge to, infinite if the turn is not allowed.
+    float Cost(int from, int to, const TurnCosts &costs) const;
+    std::size_t BannedTurns() const { return m_Banned.size(); }
+
+  private:
+    static std::uint64_t Key(int from, int to) {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(from)) << 32) | static_cast<std::uint32_t>(to);
+    }
+
+    const std::vector<Model::Node> &m_Nodes;
+    const RouteGraph::Adjacency &m_Edges;
+    std::vector<int> m_Tail;
+    std::vector<bool> m_Restricted;
+    std::vector<std::uint64_t> m_Banned;
+};
+
+#endif
@@ -1,10 +1,33 @@
 #include "gtest/gtest.h"
 #include <fstream>
 #include <iostream>
+#include <numeric>
 #include <optional>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <random>
+#include <thread>
 #include <vector>
 #include "../src/route_model.h"
 #include "../src/route_planner.h"
+#include "../src/hub_labels.h"
+#include "../src/distance_matrix.h"
+#include "../src/batch_router.h"
+#include "../src/route_cache.h"
+#include "../src/shortest_path_tree.h"
+#include "../src/delta_stepping.h"
+#include "../src/overlay.h"
+#include "../src/osm_generator.h"
+#include "../src/route_model_store.h"
+#include "../src/route_server.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <sstream>
 
 
 static std::optional<std::vector<std::byte>> ReadFile(const std::string &path)
@@ -75,13 +98,14 @@ bool NodesSame(RouteModel::Node* a, RouteModel::Node* b) { return a == b; }
 TEST_F(RoutePlannerTest, TestAddNeighbors) {
     route_planner.AddNeighbors(start_node);
 
-    // Correct h and g values for the neighbors of start_node.
-    std::vector<float> start_neighbor_g_vals{ 0.051776856, 0.055291083, 0.082997195, 0.10671431 };
-    std::vector<float> start_neighbor_h_vals{ 1.0858033, 1.1831238, 1.0998145, 1.1828455 };
+    // Correct h and g values for the neighbors of start_node. It is the crossing of two one-way
+    // streets, so only the two nodes ahead of it are neighbors.
+    std::vector<float> start_neighbor_g_vals{ 0.051776856, 0.082997195 };
+    std::vector<float> start_neighbor_h_vals{ 1.0858033, 1.0998145 };
     auto neighbors = start_node->neighbors;
     std::sort(std::begin(neighbors), std::end(neighbors),
         [](RouteModel::Node* a, RouteModel::Node* b) { return a->g_value < b->g_value; });
-    EXPECT_EQ(neighbors.size(), 4);
+    EXPECT_EQ(neighbors.size(), 2);
 
     // Check results for each neighbor.
     for (int i = 0; i < neighbors.size(); i++) {
@@ -98,27 +122,1373 @@ TEST_F(RoutePlannerTest, TestConstructFinalPath) {
     // Construct a path.
     mid_node->parent = start_node;
     end_node->parent = mid_node;
-    std::vector<RouteModel::Node> path = route_planner.ConstructFinalPath(end_node);
+    std::vector<int> path = route_planner.ConstructFinalPath(end_node);
 
     // Test the path.
-    EXPECT_EQ(path.size(), 3);
-    EXPECT_FLOAT_EQ(start_node->x, path.front().x);
-    EXPECT_FLOAT_EQ(start_node->y, path.front().y);
-    EXPECT_FLOAT_EQ(end_node->x, path.back().x);
-    EXPECT_FLOAT_EQ(end_node->y, path.back().y);
+    EXPECT_EQ(path, (std::vector<int>{start_node->Index(), mid_node->Index(), end_node->Index()}));
+    EXPECT_FLOAT_EQ(start_node->x, model.Nodes()[path.front()].x);
+    EXPECT_FLOAT_EQ(start_node->y, model.Nodes()[path.front()].y);
+    EXPECT_FLOAT_EQ(end_node->x, model.Nodes()[path.back()].x);
+    EXPECT_FLOAT_EQ(end_node->y, model.Nodes()[path.back()].y);
 }
 
 
 // Test the AStarSearch method.
 TEST_F(RoutePlannerTest, TestAStarSearch) {
     route_planner.AStarSearch();
-    EXPECT_EQ(model.path.size(), 33);
-    RouteModel::Node path_start = model.path.front();
-    RouteModel::Node path_end = model.path.back();
+    EXPECT_EQ(model.path.size(), 43);
+    const Model::Node &path_start = model.Nodes()[model.path.front()];
+    const Model::Node &path_end = model.Nodes()[model.path.back()];
     // The start_node and end_node x, y values should be the same as in the path.
     EXPECT_FLOAT_EQ(start_node->x, path_start.x);
     EXPECT_FLOAT_EQ(start_node->y, path_start.y);
     EXPECT_FLOAT_EQ(end_node->x, path_end.x);
     EXPECT_FLOAT_EQ(end_node->y, path_end.y);
-    EXPECT_FLOAT_EQ(route_planner.GetDistance(), 873.41565);
+    EXPECT_FLOAT_EQ(route_planner.GetDistance(), 999.13885);
+}
+
+
+// Test that one planner can answer several queries on the same model.
+TEST_F(RoutePlannerTest, TestRepeatedAStarSearch) {
+    route_planner.AStarSearch();
+    route_planner.AStarSearch();
+    EXPECT_EQ(model.path.size(), 43);
+    EXPECT_FLOAT_EQ(route_planner.GetDistance(), 999.13885);
+
+    // Reverse the query on the same model, then go back to the original one.
+    route_planner.SetEndpoints(90, 90, 10, 10);
+    route_planner.AStarSearch();
+    EXPECT_EQ(end_node->Index(), model.path.front());
+    EXPECT_EQ(start_node->Index(), model.path.back());
+    EXPECT_GT(route_planner.GetDistance(), 0.0f);
+
+    route_planner.SetEndpoints(10, 10, 90, 90);
+    route_planner.AStarSearch();
+    EXPECT_EQ(model.path.size(), 43);
+    EXPECT_FLOAT_EQ(route_planner.GetDistance(), 999.13885);
+}
+
+
+// Test that bidirectional A* over the road graph agrees with the forward-only search.
+TEST_F(RoutePlannerTest, TestBidirectionalAStarSearch) {
+    route_planner.GraphAStarSearch();
+    float graph_distance = route_planner.GetDistance();
+    ASSERT_FALSE(model.path.empty());
+
+    route_planner.BidirectionalAStarSearch();
+    EXPECT_NEAR(route_planner.GetDistance(), graph_distance, 1e-2);
+    EXPECT_EQ(start_node->Index(), model.path.front());
+    EXPECT_EQ(end_node->Index(), model.path.back());
+
+    // Check a spread of other queries, including a degenerate one.
+    std::vector<std::array<float, 4>> queries{
+        {90, 90, 10, 10}, {50, 50, 50, 50}, {5, 95, 95, 5}, {30, 70, 60, 20}, {0, 0, 100, 100}};
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        float expected = route_planner.GetDistance();
+        route_planner.BidirectionalAStarSearch();
+        EXPECT_NEAR(route_planner.GetDistance(), expected, 1e-2);
+    }
+}
+
+
+// Test that fastest routes agree between search directions and with an equivalent custom cost,
+// and that they are never longer in time nor shorter in meters than the shortest routes.
+TEST_F(RoutePlannerTest, TestTravelTimeCost) {
+    FastestRoutePlanner fastest_planner{model, 0, 0, 0, 0};
+    const auto seconds = model.Graph().TravelTimes();
+    BasicRoutePlanner<CustomCost> custom_planner{model, 0, 0, 0, 0, CustomCost{&seconds, 0.0f}};
+    const std::vector<std::array<float, 4>> queries{{10, 10, 90, 90}, {90, 90, 10, 10}, {5, 95, 95, 5}, {30, 70, 60, 20}};
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        EXPECT_FLOAT_EQ(route_planner.GetCost(), route_planner.GetDistance());
+        const auto shortest_path = model.path;
+
+        fastest_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        fastest_planner.GraphAStarSearch();
+        const float fastest = fastest_planner.GetCost();
+        EXPECT_GE(fastest_planner.GetDistance() + 1e-2, route_planner.GetDistance());
+        float shortest_seconds = 0.0f;
+        for (std::size_t i = 1; i < shortest_path.size(); ++i) {
+            const auto &edges = model.Graph().Forward();
+            for (int e = edges.Begin(shortest_path[i - 1]); e < edges.End(shortest_path[i - 1]); ++e) {
+                if (edges.head[e] == shortest_path[i]) {
+                    shortest_seconds += seconds[e];
+                }
+            }
+        }
+        EXPECT_LE(fastest, shortest_seconds + 1e-2);
+
+        fastest_planner.BidirectionalAStarSearch();
+        EXPECT_NEAR(fastest_planner.GetCost(), fastest, 1e-2);
+        custom_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        custom_planner.GraphAStarSearch();
+        EXPECT_NEAR(custom_planner.GetCost(), fastest, 1e-2);
+    }
+}
+
+
+// Test that walking times match RouteGraph::TravelTimes() on the foot graph, and that a travel
+// time policy built for another profile is rejected.
+TEST_F(RoutePlannerTest, TestTravelTimeCostOnFoot) {
+    const RouteGraph::Profile foot = RouteGraph::Profile::Foot;
+    FastestRoutePlanner walker{model, 0, 0, 0, 0, TravelTimeCost{foot}, foot};
+    const auto seconds = model.Graph(foot).TravelTimes();
+    BasicRoutePlanner<CustomCost> custom_walker{model, 0, 0, 0, 0, CustomCost{&seconds, 0.0f}, foot};
+    const std::vector<std::array<float, 4>> queries{{10, 10, 90, 90}, {90, 90, 10, 10}, {5, 95, 95, 5}, {30, 70, 60, 20}};
+    for (const auto &query : queries) {
+        walker.SetEndpoints(query[0], query[1], query[2], query[3]);
+        walker.GraphAStarSearch();
+        custom_walker.SetEndpoints(query[0], query[1], query[2], query[3]);
+        custom_walker.GraphAStarSearch();
+        EXPECT_NEAR(walker.GetCost(), custom_walker.GetCost(), 1e-2);
+        EXPECT_NEAR(walker.GetCost(), walker.GetDistance() / (RouteGraph::SpeedKmh(Model::Road::Footway) / 3.6f), 1e-2);
+    }
+    EXPECT_THROW((FastestRoutePlanner{model, 0, 0, 0, 0, TravelTimeCost{}, foot}), std::invalid_argument);
+    EXPECT_THROW((FastestRoutePlanner{model, 0, 0, 0, 0, TravelTimeCost{foot}}), std::invalid_argument);
+}
+
+// Test that queries between components are rejected without a search, and that snapping can
+// be restricted to the largest component.
+TEST_F(RoutePlannerTest, TestDisconnectedEndpoints) {
+    const auto &edges = model.Graph().Forward();
+    const int start = model.FindClosestNode(0.1, 0.1).Index();
+    int isolated = -1;
+    for (int v = 0; v < model.Graph().NodeCount() && isolated == -1; ++v) {
+        if (edges.End(v) > edges.Begin(v) && model.Graph().Component(v) != model.Graph().Component(start)) {
+            isolated = v;
+        }
+    }
+    ASSERT_NE(isolated, -1);
+    EXPECT_FALSE(model.Graph().MaybeReachable(start, isolated));
+
+    // Snap the end point onto the other component.
+    const auto &node = model.Nodes()[isolated];
+    route_planner.SetEndpoints(10, 10, node.x * 100, node.y * 100);
+    route_planner.AStarSearch();
+    EXPECT_TRUE(model.path.empty());
+    EXPECT_EQ(route_planner.GetDistance(), 0.0f);
+    EXPECT_EQ(route_planner.SettledNodes(), 0);
+    route_planner.BidirectionalAStarSearch();
+    EXPECT_TRUE(model.path.empty());
+    EXPECT_EQ(route_planner.SettledNodes(), 0);
+    EXPECT_TRUE(route_planner.AlternativeRoutes().empty());
+
+    RouteModel::Node &snapped = model.FindClosestNode(node.x, node.y, true);
+    EXPECT_NE(snapped.Index(), isolated);
+    EXPECT_EQ(model.Graph().StrongComponent(snapped.Index()), model.Graph().LargestStrongComponent());
+    EXPECT_TRUE(model.Graph().MaybeReachable(start, snapped.Index()));
+}
+
+// Test that the backward graph reverses the forward one edge by edge and that one-way streets
+// are only routed along their direction.
+TEST_F(RoutePlannerTest, TestOneWayEdges) {
+    const auto &forward = model.Graph().Forward();
+    const auto &backward = model.Graph().Backward();
+    ASSERT_EQ(backward.head.size(), forward.head.size());
+    int oneway_edge = -1;
+    for (int v = 0; v < model.Graph().NodeCount(); ++v) {
+        for (int e = backward.Begin(v); e < backward.End(v); ++e) {
+            const int f = backward.ForwardEdge(e);
+            EXPECT_EQ(forward.head[f], v);
+            EXPECT_TRUE(f >= forward.Begin(backward.head[e]) && f < forward.End(backward.head[e]));
+            EXPECT_EQ(forward.weight[f], backward.weight[e]);
+            EXPECT_EQ(forward.type[f], backward.type[e]);
+        }
+        for (int e = forward.Begin(v); e < forward.End(v) && oneway_edge == -1; ++e) {
+            const int u = forward.head[e];
+            if (std::find(forward.head.begin() + forward.Begin(u), forward.head.begin() + forward.End(u), v) ==
+                forward.head.begin() + forward.End(u)) {
+                oneway_edge = e;
+            }
+        }
+    }
+    ASSERT_NE(oneway_edge, -1);
+
+    // Drive the one-way edge, then try to go back against it.
+    const int head = forward.head[oneway_edge];
+    const int tail = static_cast<int>(std::upper_bound(forward.first_out.begin(), forward.first_out.end(), oneway_edge) -
+                                      forward.first_out.begin()) - 1;
+    const auto &nodes = model.Nodes();
+    route_planner.SetEndpoints(nodes[tail].x * 100, nodes[tail].y * 100, nodes[head].x * 100, nodes[head].y * 100);
+    route_planner.GraphAStarSearch();
+    EXPECT_EQ(model.path, (std::vector<int>{tail, head}));
+    EXPECT_FLOAT_EQ(route_planner.GetDistance(), forward.weight[oneway_edge]);
+    route_planner.SetEndpoints(nodes[head].x * 100, nodes[head].y * 100, nodes[tail].x * 100, nodes[tail].y * 100);
+    route_planner.GraphAStarSearch();
+    EXPECT_TRUE(model.path.empty() || model.path.size() > 2);
+    const float detour = route_planner.GetDistance();
+    route_planner.BidirectionalAStarSearch();
+    EXPECT_NEAR(route_planner.GetDistance(), detour, 1e-2);
+
+    // Custom costs are indexed by forward edge in both search directions.
+    BasicRoutePlanner<CustomCost> custom_planner{model, 0, 0, 0, 0, CustomCost{&forward.weight, 1.0f}};
+    for (const auto &query : std::vector<std::array<float, 4>>{{10, 10, 90, 90}, {90, 90, 10, 10}, {30, 70, 60, 20}}) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        custom_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        custom_planner.BidirectionalAStarSearch();
+        EXPECT_NEAR(custom_planner.GetCost(), route_planner.GetDistance(), 1e-2);
+    }
+}
+
+
+//--------------------------------------//
+//   Beginning ContractionHierarchy Tests.
+//--------------------------------------//
+
+// Sum the road graph edges along a path, failing if two consecutive nodes are not connected.
+float GraphPathLength(const RouteGraph &graph, const std::vector<int> &path) {
+    float length = 0.0f;
+    const auto &forward = graph.Forward();
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        int tail = path[i - 1];
+        int head = path[i];
+        int e = forward.Begin(tail);
+        while (e < forward.End(tail) && forward.head[e] != head) {
+            ++e;
+        }
+        EXPECT_LT(e, forward.End(tail)) << "no edge " << tail << " -> " << head;
+        if (e < forward.End(tail)) {
+            length += forward.weight[e];
+        }
+    }
+    return length;
+}
+
+// Start and end points, in percent, shared by the speedup technique tests.
+const std::vector<std::array<float, 4>> queries{
+    {10, 10, 90, 90}, {90, 90, 10, 10}, {50, 50, 50, 50}, {5, 95, 95, 5}, {30, 70, 60, 20}, {0, 0, 100, 100}};
+
+class ContractionHierarchyTest : public RoutePlannerTest {
+  protected:
+    ContractionHierarchy hierarchy{model.Graph()};
+};
+
+
+// Test that hierarchy queries find the same distances and valid, fully unpacked paths.
+TEST_F(ContractionHierarchyTest, TestQueryMatchesGraphAStar) {
+    EXPECT_GT(hierarchy.ShortcutCount(), 0);
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        float expected = route_planner.GetDistance();
+        // One-way streets leaving the map make some corners unreachable.
+        const bool reachable = !model.path.empty();
+
+        route_planner.ContractionHierarchySearch(hierarchy);
+        EXPECT_NEAR(route_planner.GetDistance(), expected, 1e-2);
+        ASSERT_EQ(model.path.empty(), !reachable);
+        EXPECT_NEAR(GraphPathLength(model.Graph(), model.path), expected, 1e-2);
+    }
+}
+
+
+// Test that a saved hierarchy loads back and answers queries the same way.
+TEST_F(ContractionHierarchyTest, TestSaveAndLoad) {
+    const std::string path = "utest_contraction_hierarchy.ch";
+    ASSERT_TRUE(hierarchy.Save(path));
+    auto loaded = ContractionHierarchy::Load(path, model.Graph());
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->ShortcutCount(), hierarchy.ShortcutCount());
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.ContractionHierarchySearch(hierarchy);
+        float expected = route_planner.GetDistance();
+        route_planner.ContractionHierarchySearch(*loaded);
+        EXPECT_FLOAT_EQ(route_planner.GetDistance(), expected);
+    }
+    EXPECT_FALSE(ContractionHierarchy::Load("does_not_exist.ch", model.Graph()).has_value());
+    std::remove(path.c_str());
+}
+
+
+// Test that a hierarchy file whose edges point outside the graph, whose offsets run backward,
+// whose ranks are not a permutation of the nodes or whose vector sizes overrun the file is
+// rejected instead of loaded.
+TEST_F(ContractionHierarchyTest, TestLoadRejectsCorruptEdges) {
+    const std::string path = "utest_contraction_hierarchy.ch";
+    ASSERT_TRUE(hierarchy.Save(path));
+    std::vector<char> saved;
+    {
+        std::ifstream is{path, std::ios::binary};
+        saved.assign(std::istreambuf_iterator<char>{is}, std::istreambuf_iterator<char>{});
+    }
+    // Header, then the rank and upward offset vectors, each after a 64-bit size.
+    const std::size_t node_count = hierarchy.NodeCount();
+    const std::size_t up_first = 20 + 8 + 4 * node_count + 8;
+    const std::size_t up = up_first + 4 * (node_count + 1) + 8;
+    ASSERT_GT(saved.size(), up + sizeof(ContractionHierarchy::Edge));
+    auto load_with = [&](std::size_t offset, std::int32_t value) {
+        std::vector<char> corrupt = saved;
+        std::memcpy(corrupt.data() + offset, &value, sizeof(value));
+        std::ofstream{path, std::ios::binary}.write(corrupt.data(), corrupt.size());
+        return ContractionHierarchy::Load(path, model.Graph());
+    };
+    std::int32_t head = 0;
+    std::memcpy(&head, saved.data() + up + offsetof(ContractionHierarchy::Edge, head), sizeof(head));
+    EXPECT_TRUE(load_with(up + offsetof(ContractionHierarchy::Edge, head), head).has_value());
+    EXPECT_FALSE(load_with(up + offsetof(ContractionHierarchy::Edge, head), node_count).has_value());
+    EXPECT_FALSE(load_with(up + offsetof(ContractionHierarchy::Edge, head), -1).has_value());
+    EXPECT_FALSE(load_with(up + offsetof(ContractionHierarchy::Edge, middle), node_count).has_value());
+    EXPECT_FALSE(load_with(up_first, 1).has_value());
+    EXPECT_FALSE(load_with(up_first + 4, -1).has_value());
+    EXPECT_FALSE(load_with(20, std::numeric_limits<std::int32_t>::max()).has_value());
+
+    // Without edges only the ranks themselves can be wrong.
+    auto load_ranks = [&](const std::vector<std::int32_t> &ranks) {
+        std::ofstream os{path, std::ios::binary};
+        os.write(saved.data(), 20);
+        auto write = [&](const std::vector<std::int32_t> &values) {
+            const std::int64_t size = values.size();
+            os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+            os.write(reinterpret_cast<const char *>(values.data()), sizeof(values[0]) * values.size());
+        };
+        const std::vector<std::int32_t> first(node_count + 1, 0);
+        write(ranks);
+        write(first);
+        write({});
+        write(first);
+        write({});
+        os.close();
+        return ContractionHierarchy::Load(path, model.Graph());
+    };
+    std::vector<std::int32_t> ranks(node_count);
+    std::iota(ranks.begin(), ranks.end(), 0);
+    EXPECT_TRUE(load_ranks(ranks).has_value());
+    ranks[0] = ranks[1];
+    EXPECT_FALSE(load_ranks(ranks).has_value());
+    ranks[0] = node_count;
+    EXPECT_FALSE(load_ranks(ranks).has_value());
+    ranks[0] = -1;
+    EXPECT_FALSE(load_ranks(ranks).has_value());
+    std::remove(path.c_str());
+}
+
+
+//--------------------------------//
+//   Beginning Landmarks Tests.
+//--------------------------------//
+
+// Test that ALT bounds never overestimate and that ALT searches keep their distances.
+TEST_F(RoutePlannerTest, TestLandmarkHeuristic) {
+    for (auto selection : {Landmarks::Selection::Farthest, Landmarks::Selection::Avoid}) {
+        Landmarks landmarks{model.Graph(), 8, selection};
+        EXPECT_EQ(landmarks.Nodes().size(), 8);
+
+        int plain_settled = 0;
+        int alt_settled = 0;
+        for (const auto &query : queries) {
+            route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+            route_planner.SetLandmarks(nullptr);
+            route_planner.GraphAStarSearch();
+            float expected = route_planner.GetDistance();
+            plain_settled += route_planner.SettledNodes();
+
+            route_planner.SetLandmarks(&landmarks);
+            route_planner.GraphAStarSearch();
+            EXPECT_NEAR(route_planner.GetDistance(), expected, 1e-2);
+            alt_settled += route_planner.SettledNodes();
+            route_planner.BidirectionalAStarSearch();
+            EXPECT_NEAR(route_planner.GetDistance(), expected, 1e-2);
+
+            if (!model.path.empty()) {
+                int source = model.path.front();
+                int target = model.path.back();
+                EXPECT_LE(landmarks.LowerBound(source, target), expected + 1e-2);
+            }
+        }
+        EXPECT_LT(alt_settled, plain_settled);
+    }
+}
+
+
+// Test that walks with landmarks of the foot graph stay shortest, and that landmarks of another
+// profile's graph are rejected.
+TEST_F(RoutePlannerTest, TestLandmarksOnFoot) {
+    const RouteGraph::Profile foot = RouteGraph::Profile::Foot;
+    Landmarks car_landmarks{model.Graph(), 8};
+    Landmarks foot_landmarks{model.Graph(foot), 8};
+    EXPECT_EQ(car_landmarks.GetProfile(), RouteGraph::Profile::Car);
+    EXPECT_EQ(foot_landmarks.GetProfile(), foot);
+
+    RoutePlanner walker{model, 0, 0, 0, 0, DistanceCost{}, foot};
+    EXPECT_THROW(walker.SetLandmarks(&car_landmarks), std::invalid_argument);
+    EXPECT_THROW(route_planner.SetLandmarks(&foot_landmarks), std::invalid_argument);
+    for (const auto &query : queries) {
+        walker.SetEndpoints(query[0], query[1], query[2], query[3]);
+        walker.SetLandmarks(nullptr);
+        walker.GraphAStarSearch();
+        const float expected = walker.GetDistance();
+        walker.SetLandmarks(&foot_landmarks);
+        walker.GraphAStarSearch();
+        EXPECT_NEAR(walker.GetDistance(), expected, 1e-2);
+    }
+}
+
+
+// Test that hub label distances match the hierarchy they were derived from.
+TEST_F(ContractionHierarchyTest, TestHubLabelDistances) {
+    HubLabels labels{hierarchy};
+    EXPECT_EQ(labels.NodeCount(), model.Graph().NodeCount());
+    EXPECT_GE(labels.AverageLabelSize(), 1.0);
+    SearchSpace forward{hierarchy.NodeCount()};
+    SearchSpace backward{hierarchy.NodeCount()};
+    for (const auto &query : queries) {
+        int source = model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f).Index();
+        int target = model.FindClosestNode(query[2] * 0.01f, query[3] * 0.01f).Index();
+        auto expected = hierarchy.Search(source, target, forward, backward);
+        if (expected.meeting_node == -1) {
+            EXPECT_EQ(labels.Distance(source, target), std::numeric_limits<float>::infinity());
+        } else {
+            EXPECT_NEAR(labels.Distance(source, target), expected.distance, 1e-2);
+        }
+    }
+    EXPECT_EQ(labels.Distance(0, 0), 0.0f);
+}
+
+
+// Test that every matrix entry matches a point-to-point hierarchy query.
+TEST_F(ContractionHierarchyTest, TestDistanceMatrix) {
+    DistanceMatrix matrix{model, hierarchy, 3};
+    auto sources = matrix.Snap({{10, 10}, {90, 90}, {50, 50}, {5, 95}, {30, 70}});
+    auto targets = matrix.Snap({{90, 90}, {10, 10}, {60, 20}, {95, 5}});
+    auto table = matrix.Compute(sources, targets);
+    ASSERT_EQ(table.size(), sources.size() * targets.size());
+
+    SearchSpace forward{hierarchy.NodeCount()};
+    SearchSpace backward{hierarchy.NodeCount()};
+    for (std::size_t i = 0; i < sources.size(); ++i) {
+        for (std::size_t j = 0; j < targets.size(); ++j) {
+            auto expected = hierarchy.Search(sources[i], targets[j], forward, backward);
+            EXPECT_FLOAT_EQ(table[i * targets.size() + j], expected.distance);
+        }
+    }
+}
+
+
+
+//--------------------------------//
+//   Beginning Batch Routing Tests.
+//--------------------------------//
+
+// Test that ParallelFor visits every index exactly once, with valid worker indices.
+TEST(ThreadPoolTest, TestParallelFor) {
+    ThreadPool pool{4};
+    std::vector<std::atomic<int>> visits(1000);
+    std::atomic<bool> bad_worker{false};
+    pool.ParallelFor(1000, [&](int i, int worker) {
+        visits[i]++;
+        if (worker < 0 || worker >= pool.Size()) {
+            bad_worker = true;
+        }
+    }, 7);
+    for (const auto &count : visits) {
+        EXPECT_EQ(count, 1);
+    }
+    EXPECT_FALSE(bad_worker);
+}
+
+
+// Test that batch results match single hierarchy queries and survive the CSV round trip.
+TEST_F(ContractionHierarchyTest, TestBatchRouter) {
+    std::istringstream input{"# start_x start_y end_x end_y\n10 10 90 90\n\n90,90,10,10\n50 50 50 50\n5 95 95 5\n"};
+    auto batch = BatchRouter::ReadQueries(input);
+    ASSERT_EQ(batch.size(), 4);
+
+    BatchRouter router{model, hierarchy, 3};
+    auto results = router.Run(batch);
+    ASSERT_EQ(results.size(), batch.size());
+    EXPECT_EQ(router.LastSummary().queries, 4);
+    EXPECT_LE(router.LastSummary().p50_us, router.LastSummary().p99_us);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        route_planner.SetEndpoints(batch[i].start_x, batch[i].start_y, batch[i].end_x, batch[i].end_y);
+        route_planner.ContractionHierarchySearch(hierarchy);
+        EXPECT_FLOAT_EQ(results[i].distance, route_planner.GetDistance());
+        EXPECT_EQ(results[i].path, model.path);
+    }
+
+    std::ostringstream csv;
+    BatchRouter::WriteCsv(csv, results);
+    std::istringstream lines{csv.str()};
+    std::string line;
+    std::getline(lines, line);
+    EXPECT_EQ(line, "query,distance_m,path");
+    std::getline(lines, line);
+    EXPECT_EQ(line.rfind("0,", 0), 0);
+}
+
+
+// Test that the route cache counts hits and misses, evicts least recently used routes and
+// drops routes computed before an invalidation.
+TEST(RouteCacheTest, TestEvictionAndInvalidation) {
+    RouteCache cache{1 << 12, 1};
+    EXPECT_EQ(cache.Find(1, 2), nullptr);
+    cache.Insert(1, 2, 10.0f, {1, 5, 2}, cache.Version());
+    auto route = cache.Find(1, 2);
+    ASSERT_NE(route, nullptr);
+    EXPECT_FLOAT_EQ(route->distance, 10.0f);
+    EXPECT_EQ(route->path, (std::vector<int>{1, 5, 2}));
+    EXPECT_EQ(cache.Find(2, 1), nullptr);
+    EXPECT_EQ(cache.Hits(), 1);
+    EXPECT_EQ(cache.Misses(), 2);
+
+    // Fill the budget while keeping (1, 2) recently used; the oldest other routes go first.
+    for (int i = 0; i < 200; ++i) {
+        cache.Insert(100 + i, 0, 1.0f, std::vector<int>(8, i), cache.Version());
+        cache.Find(1, 2);
+    }
+    EXPECT_LE(cache.MemoryBytes(), 1 << 12);
+    EXPECT_NE(cache.Find(1, 2), nullptr);
+    EXPECT_NE(cache.Find(299, 0), nullptr);
+    EXPECT_EQ(cache.Find(100, 0), nullptr);
+
+    auto version = cache.Version();
+    cache.Invalidate();
+    EXPECT_EQ(cache.Find(1, 2), nullptr);
+    EXPECT_EQ(cache.MemoryBytes(), 0);
+    cache.Insert(1, 2, 10.0f, {1, 2}, version);
+    EXPECT_EQ(cache.Find(1, 2), nullptr);
+    cache.Insert(1, 2, 10.0f, {1, 2}, cache.Version());
+    EXPECT_EQ(cache.Find(1, 2, version), nullptr);
+    EXPECT_NE(cache.Find(1, 2, cache.Version()), nullptr);
+}
+
+
+// Test that cached batch results are identical to searched ones.
+TEST_F(ContractionHierarchyTest, TestBatchRouterCache) {
+    std::vector<BatchRouter::Query> batch;
+    for (int i = 0; i < 3; ++i) {
+        for (const auto &q : queries) {
+            batch.push_back({q[0], q[1], q[2], q[3]});
+        }
+    }
+    BatchRouter router{model, hierarchy, 2};
+    auto expected = router.Run(batch);
+
+    RouteCache cache{1 << 20};
+    router.SetCache(&cache);
+    router.Run(batch);
+    auto results = router.Run(batch);
+    EXPECT_EQ(router.LastSummary().cache_hits, batch.size());
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_TRUE(results[i].cached);
+        EXPECT_FLOAT_EQ(results[i].distance, expected[i].distance);
+        EXPECT_EQ(results[i].path, expected[i].path);
+    }
+}
+
+
+//--------------------------------//
+//   Beginning Shortest Path Tree Tests.
+//--------------------------------//
+
+// Test that tree distances and paths match point-to-point searches.
+TEST_F(RoutePlannerTest, TestShortestPathTree) {
+    for (const auto &query : queries) {
+        int source = model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f).Index();
+        int target = model.FindClosestNode(query[2] * 0.01f, query[3] * 0.01f).Index();
+        auto tree = model.ShortestPaths(source);
+        EXPECT_EQ(tree.Nodes().front(), source);
+
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        ASSERT_EQ(tree.Contains(target), !model.path.empty());
+        if (model.path.empty()) {
+            continue;
+        }
+        EXPECT_NEAR(tree.Distance(target), route_planner.GetDistance(), 0.5);
+        auto path = tree.PathTo(target);
+        ASSERT_FALSE(path.empty());
+        EXPECT_EQ(path.front(), source);
+        EXPECT_EQ(path.back(), target);
+        for (std::size_t i = 1; i < path.size(); ++i) {
+            EXPECT_EQ(tree.Parent(path[i]), path[i - 1]);
+            EXPECT_LE(tree.Distance(path[i - 1]), tree.Distance(path[i]));
+        }
+    }
+}
+
+
+// Test that a cutoff keeps exactly the nodes within it and that the isochrone hull encloses them.
+TEST_F(RoutePlannerTest, TestIsochrone) {
+    int source = model.FindClosestNode(0.5f, 0.5f).Index();
+    auto full = model.ShortestPaths(source);
+    const float cutoff = 300.0f;
+    auto bounded = model.ShortestPaths(source, cutoff);
+    for (int v = 0; v < model.Graph().NodeCount(); ++v) {
+        EXPECT_EQ(bounded.Contains(v), full.Distance(v) <= cutoff);
+        if (bounded.Contains(v)) {
+            EXPECT_FLOAT_EQ(bounded.Distance(v), full.Distance(v));
+        }
+    }
+
+    auto isochrone = model.FindIsochrone(source, cutoff);
+    EXPECT_EQ(isochrone.nodes, bounded.Nodes());
+    ASSERT_GE(isochrone.hull.size(), 3);
+    const auto &nodes = model.Nodes();
+    for (std::size_t i = 0; i < isochrone.hull.size(); ++i) {
+        const auto &a = nodes[isochrone.hull[i]];
+        const auto &b = nodes[isochrone.hull[(i + 1) % isochrone.hull.size()]];
+        for (int v : isochrone.nodes) {
+            EXPECT_GE((b.x - a.x) * (nodes[v].y - a.y) - (b.y - a.y) * (nodes[v].x - a.x), -1e-12);
+        }
+    }
+    EXPECT_TRUE(model.ShortestPaths(source, -1.0f).Nodes().empty());
+
+    // On foot the shortest paths and the isochrone follow the foot graph.
+    const RouteGraph::Profile foot = RouteGraph::Profile::Foot;
+    const int walk_source = model.FindClosestNode(0.5f, 0.5f, false, foot).Index();
+    auto walk = model.ShortestPaths(walk_source, cutoff, foot);
+    EXPECT_EQ(model.FindIsochrone(walk_source, cutoff, foot).nodes, walk.Nodes());
+    ShortestPathTree expected{model.Graph(foot), walk_source, cutoff};
+    EXPECT_EQ(walk.Nodes(), expected.Nodes());
+}
+
+
+// Test that parallel delta-stepping finds the same distances as a Dijkstra pass for any delta.
+TEST_F(RoutePlannerTest, TestDeltaStepping) {
+    DeltaStepping delta_stepping{model.Graph(), 50.0f, 4};
+    for (int source : {0, model.Graph().NodeCount() / 2, model.FindClosestNode(0.5f, 0.5f).Index()}) {
+        auto tree = model.ShortestPaths(source);
+        for (float delta : {1.0f, 50.0f, 5000.0f}) {
+            delta_stepping.SetDelta(delta);
+            const auto &distances = delta_stepping.Run(source);
+            ASSERT_EQ(distances.size(), model.Graph().NodeCount());
+            for (int v = 0; v < model.Graph().NodeCount(); ++v) {
+                if (tree.Contains(v)) {
+                    EXPECT_NEAR(distances[v], tree.Distance(v), 0.5f);
+                } else {
+                    EXPECT_EQ(distances[v], std::numeric_limits<float>::infinity());
+                }
+            }
+        }
+    }
+}
+
+
+//--------------------------------//
+//   Beginning Overlay Tests.
+//--------------------------------//
+
+// Plain Dijkstra distance over the road graph with the given edge weights.
+float ReferenceDistance(const RouteGraph &graph, const std::vector<float> &weights, int source, int target) {
+    const auto &forward = graph.Forward();
+    std::vector<float> distance(graph.NodeCount(), std::numeric_limits<float>::infinity());
+    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<>> queue;
+    distance[source] = 0.0f;
+    queue.emplace(0.0f, source);
+    while (!queue.empty()) {
+        auto [d, u] = queue.top();
+        queue.pop();
+        if (d > distance[u]) {
+            continue;
+        }
+        for (int e = forward.Begin(u); e < forward.End(u); ++e) {
+            if (d + weights[e] < distance[forward.head[e]]) {
+                distance[forward.head[e]] = d + weights[e];
+                queue.emplace(distance[forward.head[e]], forward.head[e]);
+            }
+        }
+    }
+    return distance[target];
+}
+
+// Test that overlay queries stay exact after customizing for travel times and road closures,
+// and that their unpacked paths only use open edges of the current metric.
+TEST_F(RoutePlannerTest, TestOverlayCustomization) {
+    const RouteGraph &graph = model.Graph();
+    Partition partition{model, graph, {16, 128, 1024}};
+    for (int l = 1; l < partition.LevelCount(); ++l) {
+        EXPECT_LT(partition.CellCount(l), partition.CellCount(l - 1));
+    }
+    Overlay overlay{graph, partition, 2};
+
+    // Close every road of the route found on the original lengths.
+    route_planner.OverlaySearch(overlay);
+    auto closed = graph.Forward().weight;
+    for (std::size_t i = 1; i < model.path.size(); ++i) {
+        for (int e = graph.Forward().Begin(model.path[i - 1]); e < graph.Forward().End(model.path[i - 1]); ++e) {
+            if (graph.Forward().head[e] == model.path[i]) {
+                closed[e] = std::numeric_limits<float>::infinity();
+            }
+        }
+    }
+
+    for (const auto &weights : {graph.Forward().weight, graph.TravelTimes(), closed}) {
+        overlay.Customize(weights);
+        for (const auto &query : queries) {
+            route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+            route_planner.OverlaySearch(overlay);
+            int source = model.FindClosestNode(query[0] * 0.01f, query[1] * 0.01f).Index();
+            int target = model.FindClosestNode(query[2] * 0.01f, query[3] * 0.01f).Index();
+            float expected = ReferenceDistance(graph, weights, source, target);
+            if (expected == std::numeric_limits<float>::infinity()) {
+                EXPECT_TRUE(model.path.empty());
+                continue;
+            }
+            EXPECT_NEAR(route_planner.GetCost(), expected, 1e-2);
+            ASSERT_FALSE(model.path.empty());
+            EXPECT_EQ(model.path.front(), source);
+            EXPECT_EQ(model.path.back(), target);
+            float length = 0.0f;
+            for (std::size_t i = 1; i < model.path.size(); ++i) {
+                float best = std::numeric_limits<float>::infinity();
+                for (int e = graph.Forward().Begin(model.path[i - 1]); e < graph.Forward().End(model.path[i - 1]); ++e) {
+                    if (graph.Forward().head[e] == model.path[i]) {
+                        best = std::min(best, weights[e]);
+                    }
+                }
+                length += best;
+            }
+            EXPECT_NEAR(length, expected, 1e-2);
+        }
+    }
+}
+
+
+//--------------------------------//
+//   Beginning Alternative Routes Tests.
+//--------------------------------//
+
+// Test that alternative routes are valid, bounded in cost and not too similar to earlier ones.
+TEST_F(RoutePlannerTest, TestAlternativeRoutes) {
+    const auto &edges = model.Graph().Forward();
+    int alternatives = 0;
+    for (const auto &query : std::vector<std::array<float, 4>>{{10, 10, 90, 90}, {5, 95, 95, 5}, {30, 70, 60, 20}}) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        const float optimal = route_planner.GetCost();
+
+        auto routes = route_planner.AlternativeRoutes(2);
+        ASSERT_FALSE(routes.empty());
+        EXPECT_LE(routes.size(), 3);
+        EXPECT_NEAR(routes[0].cost, optimal, 1e-2);
+        EXPECT_EQ(model.path, routes[0].path);
+        alternatives += static_cast<int>(routes.size()) - 1;
+
+        std::vector<std::pair<int, int>> earlier_edges;
+        for (const auto &route : routes) {
+            EXPECT_GE(route.cost, optimal - 1e-2);
+            EXPECT_LE(route.cost, 1.25f * optimal + 1e-2);
+            EXPECT_NEAR(GraphPathLength(model.Graph(), route.path), route.distance, 1e-2);
+            EXPECT_EQ(route.path.front(), routes[0].path.front());
+            EXPECT_EQ(route.path.back(), routes[0].path.back());
+
+            float shared = 0.0f;
+            std::vector<std::pair<int, int>> route_edges;
+            for (std::size_t i = 1; i < route.path.size(); ++i) {
+                route_edges.emplace_back(route.path[i - 1], route.path[i]);
+                if (std::find(earlier_edges.begin(), earlier_edges.end(), route_edges.back()) != earlier_edges.end()) {
+                    for (int e = edges.Begin(route.path[i - 1]); e < edges.End(route.path[i - 1]); ++e) {
+                        shared += edges.head[e] == route.path[i] ? edges.weight[e] : 0.0f;
+                    }
+                }
+            }
+            if (&route != &routes[0]) {
+                EXPECT_LE(shared, 0.8f * optimal + 1e-2);
+            }
+            earlier_edges.insert(earlier_edges.end(), route_edges.begin(), route_edges.end());
+        }
+    }
+    EXPECT_GT(alternatives, 0);
+}
+
+
+//--------------------------------//
+//   Beginning Turn Restriction Tests.
+//--------------------------------//
+
+// Test that turn-aware routes avoid banned turns, match node routes without restrictions or
+// penalties in the way, and never get cheaper with turn costs.
+TEST_F(RoutePlannerTest, TestTurnAwareSearch) {
+    ASSERT_FALSE(model.TurnRestrictions().empty());
+    EXPECT_GT(model.Turns().BannedTurns(), 0);
+
+    // Route across the via node of the first restriction, from the from way onto the to way.
+    const auto &restriction = model.TurnRestrictions()[0];
+    auto neighbor = [&](int way) {
+        const auto &nodes = model.Ways()[way].nodes;
+        auto it = std::find(nodes.begin(), nodes.end(), restriction.via);
+        return it == nodes.begin() ? *(it + 1) : *(it - 1);
+    };
+    const int from = neighbor(restriction.from);
+    const int to = neighbor(restriction.to);
+    const auto &nodes = model.Nodes();
+    route_planner.SetEndpoints(nodes[from].x * 100, nodes[from].y * 100, nodes[to].x * 100, nodes[to].y * 100);
+    route_planner.GraphAStarSearch();
+    EXPECT_EQ(model.path, (std::vector<int>{from, restriction.via, to}));
+    const float direct = route_planner.GetDistance();
+    route_planner.TurnAwareSearch();
+    ASSERT_FALSE(model.path.empty());
+    EXPECT_EQ(model.path.front(), from);
+    EXPECT_EQ(model.path.back(), to);
+    EXPECT_GT(route_planner.GetDistance(), direct);
+    EXPECT_NEAR(GraphPathLength(model.Graph(), model.path), route_planner.GetDistance(), 1e-2);
+    for (std::size_t i = 2; i < model.path.size(); ++i) {
+        EXPECT_FALSE(model.path[i - 2] == from && model.path[i - 1] == restriction.via && model.path[i] == to);
+    }
+
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.GraphAStarSearch();
+        const float expected = route_planner.GetDistance();
+        route_planner.SetTurnCosts({});
+        route_planner.TurnAwareSearch();
+        EXPECT_NEAR(route_planner.GetDistance(), expected, 1e-2);
+        route_planner.SetTurnCosts({20.0f, 5.0f, 100.0f});
+        route_planner.TurnAwareSearch();
+        EXPECT_GE(route_planner.GetCost(), expected - 1e-2);
+        EXPECT_GE(route_planner.GetCost(), route_planner.GetDistance() - 1e-2);
+    }
+}
+
+
+//--------------------------------//
+//   Beginning Profile Tests.
+//--------------------------------//
+
+// Test that the foot graph is built once for all threads, shares the model's nodes, walks
+// footways and ignores one-way streets.
+TEST_F(RoutePlannerTest, TestFootProfile) {
+    std::vector<const RouteGraph *> graphs(4, nullptr);
+    std::vector<std::thread> threads;
+    for (auto &graph : graphs) {
+        threads.emplace_back([&] { graph = &model.Graph(RouteGraph::Profile::Foot); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const RouteGraph &foot = *graphs[0];
+    for (const RouteGraph *graph : graphs) {
+        EXPECT_EQ(graph, &foot);
+    }
+    const RouteGraph &car = model.Graph();
+    EXPECT_NE(&foot, &car);
+    EXPECT_EQ(foot.NodeCount(), car.NodeCount());
+    EXPECT_GT(foot.EdgeCount(), car.EdgeCount());
+
+    int footway_node = -1;
+    for (int v = 0; v < foot.NodeCount(); ++v) {
+        const int degree = foot.Forward().End(v) - foot.Forward().Begin(v);
+        EXPECT_EQ(foot.Backward().End(v) - foot.Backward().Begin(v), degree);
+        const bool on_car_road = car.Forward().End(v) > car.Forward().Begin(v) || car.Backward().End(v) > car.Backward().Begin(v);
+        if (degree > 0 && !on_car_road && footway_node == -1) {
+            footway_node = v;
+        }
+    }
+    ASSERT_NE(footway_node, -1);
+    const auto &node = model.Nodes()[footway_node];
+    EXPECT_EQ(model.FindClosestNode(node.x, node.y, false, RouteGraph::Profile::Foot).Index(), footway_node);
+    EXPECT_NE(model.FindClosestNode(node.x, node.y).Index(), footway_node);
+
+    // Walking routes are the same length both ways. Footpath fragments are common, so snap to the
+    // largest component.
+    RoutePlanner walker{model, 0, 0, 0, 0, DistanceCost{}, RouteGraph::Profile::Foot};
+    walker.SetSnapToLargestComponent(true);
+    for (const auto &query : std::vector<std::array<float, 4>>{{10, 10, 90, 90}, {5, 95, 95, 5}, {30, 70, 60, 20}}) {
+        walker.SetEndpoints(query[0], query[1], query[2], query[3]);
+        walker.GraphAStarSearch();
+        ASSERT_FALSE(model.path.empty());
+        const float there = walker.GetDistance();
+        EXPECT_NEAR(GraphPathLength(foot, model.path), there, 1e-2);
+        walker.SetEndpoints(query[2], query[3], query[0], query[1]);
+        walker.BidirectionalAStarSearch();
+        EXPECT_NEAR(walker.GetDistance(), there, 1e-2);
+    }
+}
+
+
+// Search Stats Tests
+// ----------------------------------------------------------------------------------------------
+
+// Test that the counters of every search add up: a node is settled only after it was popped,
+// popped only after it was pushed, and the counters restart with every search.
+TEST_F(RoutePlannerTest, TestSearchStats) {
+    route_planner.AStarSearch();
+    SearchStats legacy = route_planner.Stats();
+    EXPECT_EQ(legacy.settled_nodes, route_planner.SettledNodes());
+    EXPECT_EQ(legacy.heap_pops, legacy.settled_nodes);
+    EXPECT_GE(legacy.heap_pushes, legacy.heap_pops);
+    EXPECT_EQ(legacy.relaxed_edges, legacy.heap_pushes);
+    EXPECT_GT(legacy.max_open_list, 0);
+    EXPECT_GT(legacy.snap_us, 0.0);
+    EXPECT_GT(legacy.search_us, 0.0);
+
+    const double snap_us = legacy.snap_us;
+    for (auto search : {&RoutePlanner::GraphAStarSearch, &RoutePlanner::BidirectionalAStarSearch,
+                        &RoutePlanner::TurnAwareSearch}) {
+        (route_planner.*search)();
+        const SearchStats &stats = route_planner.Stats();
+        ASSERT_GT(stats.settled_nodes, 0);
+        EXPECT_GE(stats.heap_pops, stats.settled_nodes);
+        EXPECT_GE(stats.heap_pushes, stats.heap_pops);
+        EXPECT_GE(stats.relaxed_edges, stats.heap_pushes - 2);
+        EXPECT_GT(stats.max_open_list, 0);
+        EXPECT_LE(stats.max_open_list, stats.heap_pushes);
+        EXPECT_GT(stats.search_us, 0.0);
+        // The endpoints were snapped once, before all of these searches.
+        EXPECT_EQ(stats.snap_us, snap_us);
+    }
+    route_planner.GraphAStarSearch();
+    const int settled = route_planner.Stats().settled_nodes;
+    route_planner.GraphAStarSearch();
+    EXPECT_EQ(route_planner.Stats().settled_nodes, settled);
+
+    // Endpoints snapped before the planner existed keep the snapping time they were given.
+    RoutePlanner presnapped{model, model.SNodes()[model.path.front()], model.SNodes()[model.path.back()], 12.5};
+    presnapped.GraphAStarSearch();
+    EXPECT_EQ(presnapped.Stats().snap_us, 12.5);
+    EXPECT_EQ(presnapped.Stats().settled_nodes, settled);
+}
+
+// Test that histograms count every query, keep percentiles ordered and close to the exact
+// values, and merge into the same counts as one histogram fed all queries.
+TEST(SearchStatsHistogramTest, TestPercentiles) {
+    SearchStatsHistogram all;
+    SearchStatsHistogram even;
+    SearchStatsHistogram odd;
+    for (int i = 1; i <= 1000; ++i) {
+        SearchStats stats;
+        stats.settled_nodes = i;
+        stats.search_us = 0.5 * i;
+        all.Add(stats);
+        (i % 2 ? odd : even).Add(stats);
+    }
+    EXPECT_EQ(all.Count(), 1000);
+    EXPECT_NEAR(all.Mean(SearchStatsHistogram::SettledNodes), 500.5, 1e-9);
+    EXPECT_EQ(all.Max(SearchStatsHistogram::SettledNodes), 1000.0);
+    EXPECT_EQ(all.Percentile(SearchStatsHistogram::RelaxedEdges, 0.99), 0.0);
+    double previous = 0.0;
+    for (double fraction : {0.1, 0.5, 0.9, 0.99}) {
+        double p = all.Percentile(SearchStatsHistogram::SettledNodes, fraction);
+        EXPECT_GE(p, fraction * 1000);
+        EXPECT_LE(p, fraction * 1000 * 1.2);
+        EXPECT_GE(p, previous);
+        previous = p;
+    }
+    EXPECT_EQ(all.Percentile(SearchStatsHistogram::SettledNodes, 1.0), 1000.0);
+
+    even.Merge(odd);
+    EXPECT_EQ(even.Count(), all.Count());
+    for (int m = 0; m < SearchStatsHistogram::kMetricCount; ++m) {
+        auto metric = static_cast<SearchStatsHistogram::Metric>(m);
+        EXPECT_DOUBLE_EQ(even.Mean(metric), all.Mean(metric));
+        EXPECT_EQ(even.Max(metric), all.Max(metric));
+        EXPECT_EQ(even.Percentile(metric, 0.9), all.Percentile(metric, 0.9));
+    }
+    std::ostringstream printed;
+    all.Print(printed);
+    EXPECT_NE(printed.str().find("settled_nodes"), std::string::npos);
+}
+
+
+// Search Trace Tests
+// ----------------------------------------------------------------------------------------------
+
+// Test that a trace holds every settled node in order, restarts with every search and survives
+// a round trip through its binary file.
+TEST_F(ContractionHierarchyTest, TestSearchTrace) {
+    SearchTrace trace;
+    route_planner.SetTrace(&trace);
+    route_planner.GraphAStarSearch();
+    ASSERT_FALSE(model.path.empty());
+    ASSERT_EQ(trace.Size(), route_planner.SettledNodes());
+    EXPECT_EQ(trace.Entries().front().node, model.path.front());
+    EXPECT_EQ(trace.Entries().back().node, model.path.back());
+
+    route_planner.BidirectionalAStarSearch();
+    ASSERT_EQ(trace.Size(), route_planner.SettledNodes());
+    int backward = 0;
+    for (const auto &entry : trace.Entries()) {
+        backward += entry.backward;
+    }
+    EXPECT_GT(backward, 0);
+    EXPECT_LT(backward, trace.Size());
+
+    const std::string path = "utest_search_trace.bin";
+    const int node_count = static_cast<int>(model.Nodes().size());
+    ASSERT_TRUE(trace.Save(path, node_count));
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    EXPECT_LT(file.tellg(), 16 + 3 * trace.Size());
+    auto loaded = SearchTrace::Load(path, node_count);
+    ASSERT_TRUE(loaded.has_value());
+    ASSERT_EQ(loaded->Size(), trace.Size());
+    for (int i = 0; i < trace.Size(); ++i) {
+        EXPECT_EQ(loaded->Entries()[i].node, trace.Entries()[i].node);
+        EXPECT_EQ(loaded->Entries()[i].backward, trace.Entries()[i].backward);
+    }
+    EXPECT_FALSE(SearchTrace::Load(path, node_count + 1).has_value());
+    std::remove(path.c_str());
+
+    // Hierarchy searches are traced after the fact, with every settled node once.
+    route_planner.ContractionHierarchySearch(hierarchy);
+    const int hierarchy_settled = route_planner.SettledNodes();
+    EXPECT_EQ(trace.Size(), hierarchy_settled);
+    route_planner.SetTrace(nullptr);
+    route_planner.GraphAStarSearch();
+    EXPECT_NE(route_planner.SettledNodes(), hierarchy_settled);
+    EXPECT_EQ(trace.Size(), hierarchy_settled);
+}
+
+
+// Synthetic Map Tests
+// ----------------------------------------------------------------------------------------------
+
+static std::vector<std::byte> SyntheticOSMData(const SyntheticCity &city, std::int64_t *node_count = nullptr) {
+    std::ostringstream os;
+    const auto nodes = WriteSyntheticCity(os, city);
+    if (node_count) {
+        *node_count = nodes;
+    }
+    const std::string xml = os.str();
+    std::vector<std::byte> data(xml.size());
+    std::transform(xml.begin(), xml.end(), data.begin(), [](char c) { return static_cast<std::byte>(c); });
+    return data;
+}
+
+// Test that a generated city loads with every node, road, building and multipolygon, and that
+// the shortest route across a grid of two-way streets is as long as the Manhattan distance.
+TEST(SyntheticCityTest, TestGridCity) {
+    SyntheticCity city;
+    city.target_nodes = 3000;
+    city.oneway_fraction = 0.0;
+    city.footway = 0.0;
+    std::int64_t node_count = 0;
+    RouteModel model{SyntheticOSMData(city, &node_count)};
+    EXPECT_EQ(static_cast<std::int64_t>(model.Nodes().size()), node_count);
+    EXPECT_NEAR(node_count, city.target_nodes, 0.1 * city.target_nodes);
+    EXPECT_FALSE(model.Roads().empty());
+    EXPECT_FALSE(model.Buildings().empty());
+    std::size_t rings = 0;
+    for (const auto &landuse : model.Landuses()) {
+        EXPECT_EQ(landuse.outer.size(), 1);
+        EXPECT_EQ(landuse.inner.size(), 1);
+        rings++;
+    }
+    EXPECT_GT(rings, 0);
+
+    const RouteGraph &graph = model.Graph();
+    RoutePlanner planner{model, 0, 0, 100, 100};
+    planner.GraphAStarSearch();
+    ASSERT_FALSE(model.path.empty());
+    const auto &start = model.Nodes()[model.path.front()];
+    const auto &end = model.Nodes()[model.path.back()];
+    const float manhattan = (std::abs(end.x - start.x) + std::abs(end.y - start.y)) * model.MetricScale();
+    EXPECT_NEAR(planner.GetDistance(), manhattan, 1e-3 * manhattan);
+    EXPECT_EQ(graph.Component(model.path.front()), graph.Component(model.path.back()));
+
+    // The same parameters always give the same map.
+    EXPECT_EQ(SyntheticOSMData(city), SyntheticOSMData(city));
+}
+
+// Test that the random planar layout differs from the grid but stays routable, with
+// diagonal streets and one-way streets honored by every search.
+TEST(SyntheticCityTest, TestRandomPlanarCity) {
+    SyntheticCity city;
+    city.layout = SyntheticCity::Layout::RandomPlanar;
+    city.target_nodes = 3000;
+    RouteModel model{SyntheticOSMData(city)};
+    SyntheticCity grid = city;
+    grid.layout = SyntheticCity::Layout::Grid;
+    EXPECT_NE(SyntheticOSMData(city), SyntheticOSMData(grid));
+    city.seed = 2;
+    EXPECT_NE(SyntheticOSMData(city), SyntheticOSMData(grid));
+
+    const RouteGraph &graph = model.Graph();
+    EXPECT_GT(graph.NodeCount(), 0);
+    RoutePlanner planner{model, 0, 0, 0, 0};
+    planner.SetSnapToLargestComponent(true);
+    for (const auto &query : std::vector<std::array<float, 4>>{{5, 5, 95, 95}, {95, 10, 10, 90}, {50, 0, 50, 100}}) {
+        planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        planner.GraphAStarSearch();
+        ASSERT_FALSE(model.path.empty());
+        const float expected = planner.GetDistance();
+        planner.BidirectionalAStarSearch();
+        EXPECT_NEAR(planner.GetDistance(), expected, 1e-2);
+        planner.AStarSearch();
+        EXPECT_GE(planner.GetDistance(), expected * (1.0f - 1e-4f));
+    }
+}
+
+
+// Test that landmark bounds stay consistent and landmark searches exact on a synthetic country
+// of 300 km blocks, where the 16-bit landmark tables are rounded to units of many meters.
+TEST(SyntheticCityTest, TestLandmarksMatchDijkstra) {
+    SyntheticCity city;
+    city.layout = SyntheticCity::Layout::RandomPlanar;
+    city.target_nodes = 60000;
+    city.block_meters = 300000.0;
+    city.shape_points = 3000;
+    RouteModel model{SyntheticOSMData(city)};
+    const RouteGraph &graph = model.Graph();
+    Landmarks landmarks{graph, 8};
+    RoutePlanner planner{model, 0, 0, 0, 0};
+    planner.SetSnapToLargestComponent(true);
+    planner.SetLandmarks(&landmarks);
+    std::mt19937 random{3};
+    std::uniform_real_distribution<float> percent{0.0f, 100.0f};
+    const RouteGraph::Adjacency &forward = graph.Forward();
+    for (int i = 0; i < 10; ++i) {
+        const int target = random() % graph.NodeCount();
+        for (int v = 0; v < graph.NodeCount(); ++v) {
+            for (int e = forward.Begin(v); e < forward.End(v); ++e) {
+                ASSERT_LE(landmarks.LowerBound(v, target), forward.weight[e] + landmarks.LowerBound(forward.head[e], target));
+            }
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        planner.SetEndpoints(percent(random), percent(random), percent(random), percent(random));
+        planner.GraphAStarSearch();
+        ASSERT_FALSE(model.path.empty());
+        const float expected = ReferenceDistance(graph, graph.Forward().weight, model.path.front(), model.path.back());
+        EXPECT_NEAR(planner.GetDistance(), expected, expected * 1e-6f);
+        planner.BidirectionalAStarSearch();
+        EXPECT_NEAR(planner.GetDistance(), expected, expected * 1e-6f);
+    }
+}
+
+
+// Test that protocol frames round trip, also when they arrive a few bytes at a time, and that
+// malformed frames are rejected.
+TEST(RouteServerTest, TestProtocolFrames) {
+    RouteServer::Request route{7, RouteServer::Type::Route, 10, 20, 90, 80};
+    RouteServer::Request snap{8, RouteServer::Type::Snap, 50, 50};
+    std::vector<std::byte> buffer;
+    RouteServer::AppendRequest(buffer, route);
+    RouteServer::AppendRequest(buffer, snap);
+    EXPECT_EQ(buffer.size(), 25 + 17);
+
+    RouteServer::Request parsed;
+    for (std::size_t size = 0; size < 25; ++size) {
+        EXPECT_EQ(RouteServer::ParseRequest(buffer.data(), size, parsed), 0);
+    }
+    ASSERT_EQ(RouteServer::ParseRequest(buffer.data(), buffer.size(), parsed), 25);
+    EXPECT_EQ(parsed.id, 7);
+    EXPECT_EQ(parsed.type, RouteServer::Type::Route);
+    EXPECT_FLOAT_EQ(parsed.start_y, 20);
+    EXPECT_FLOAT_EQ(parsed.end_x, 90);
+    ASSERT_EQ(RouteServer::ParseRequest(buffer.data() + 25, buffer.size() - 25, parsed), 17);
+    EXPECT_EQ(parsed.id, 8);
+    EXPECT_EQ(parsed.type, RouteServer::Type::Snap);
+    EXPECT_FLOAT_EQ(parsed.start_x, 50);
+
+    std::vector<std::byte> bad = buffer;
+    bad[8] = std::byte{9};
+    EXPECT_EQ(RouteServer::ParseRequest(bad.data(), bad.size(), parsed), -1);
+    bad = buffer;
+    bad[0] = std::byte{200};
+    EXPECT_EQ(RouteServer::ParseRequest(bad.data(), bad.size(), parsed), -1);
+
+    RouteServer::Response response;
+    response.id = 3;
+    response.distance = 1234.5f;
+    response.path = {4, 8, 15, 16, 23, 42};
+    RouteServer::Response snapped;
+    snapped.id = 4;
+    snapped.type = RouteServer::Type::Snap;
+    snapped.node = 99;
+    snapped.x = 0.25f;
+    snapped.y = 0.75f;
+    buffer.clear();
+    RouteServer::AppendResponse(buffer, response);
+    const std::size_t first = buffer.size();
+    RouteServer::AppendResponse(buffer, snapped);
+    RouteServer::Response out;
+    EXPECT_EQ(RouteServer::ParseResponse(buffer.data(), first - 1, out), 0);
+    ASSERT_EQ(RouteServer::ParseResponse(buffer.data(), buffer.size(), out), static_cast<long>(first));
+    EXPECT_EQ(out.id, 3);
+    EXPECT_EQ(out.status, RouteServer::Status::Ok);
+    EXPECT_FLOAT_EQ(out.distance, 1234.5f);
+    EXPECT_EQ(out.path, response.path);
+    ASSERT_EQ(RouteServer::ParseResponse(buffer.data() + first, buffer.size() - first, out),
+              static_cast<long>(buffer.size() - first));
+    EXPECT_EQ(out.type, RouteServer::Type::Snap);
+    EXPECT_EQ(out.node, 99);
+    EXPECT_FLOAT_EQ(out.y, 0.75f);
+}
+
+
+// Test that the server answers pipelined requests over a Unix domain socket like a hierarchy
+// search, with every response matched to its request by id.
+TEST_F(ContractionHierarchyTest, TestRouteServer) {
+    const std::string path = "/tmp/route_server_test_" + std::to_string(getpid()) + ".sock";
+    RouteServer server{model, hierarchy, 3};
+    ASSERT_TRUE(server.ListenUnix(path));
+    std::thread loop{[&] { server.Run(); }};
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    std::vector<RouteServer::Request> requests;
+    for (std::uint32_t i = 0; i < 300; ++i) {
+        const auto &query = queries[i % queries.size()];
+        const auto type = i % 3 == 0 ? RouteServer::Type::Route : i % 3 == 1 ? RouteServer::Type::Distance
+                                                                            : RouteServer::Type::Snap;
+        requests.push_back({i, type, query[0], query[1], query[2], query[3]});
+    }
+    std::vector<std::byte> out;
+    for (const auto &request : requests) {
+        RouteServer::AppendRequest(out, request);
+    }
+    // Send everything at once, more than the server takes in flight per connection, with the
+    // last frame split in two writes.
+    ASSERT_EQ(send(fd, out.data(), out.size() - 5, 0), static_cast<ssize_t>(out.size() - 5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(send(fd, out.data() + out.size() - 5, 5, 0), 5);
+
+    std::vector<std::optional<RouteServer::Response>> responses(requests.size());
+    std::vector<std::byte> in;
+    std::size_t received = 0;
+    while (received < requests.size()) {
+        std::array<std::byte, 4096> chunk;
+        ssize_t count = recv(fd, chunk.data(), chunk.size(), 0);
+        ASSERT_GT(count, 0);
+        in.insert(in.end(), chunk.begin(), chunk.begin() + count);
+        RouteServer::Response response;
+        long size;
+        while ((size = RouteServer::ParseResponse(in.data(), in.size(), response)) > 0) {
+            ASSERT_LT(response.id, requests.size());
+            EXPECT_FALSE(responses[response.id]);
+            responses[response.id] = response;
+            in.erase(in.begin(), in.begin() + size);
+            ++received;
+        }
+        ASSERT_EQ(size, 0);
+    }
+    close(fd);
+    server.Stop();
+    loop.join();
+
+    for (const auto &request : requests) {
+        const RouteServer::Response &response = *responses[request.id];
+        EXPECT_EQ(response.type, request.type);
+        if (request.type == RouteServer::Type::Snap) {
+            const auto &node = model.FindClosestNode(request.start_x * 0.01f, request.start_y * 0.01f);
+            EXPECT_EQ(response.node, node.Index());
+            EXPECT_FLOAT_EQ(response.x, node.x);
+            continue;
+        }
+        route_planner.SetEndpoints(request.start_x, request.start_y, request.end_x, request.end_y);
+        route_planner.ContractionHierarchySearch(hierarchy);
+        if (model.path.empty()) {
+            EXPECT_EQ(response.status, RouteServer::Status::NoRoute);
+            continue;
+        }
+        ASSERT_EQ(response.status, RouteServer::Status::Ok);
+        EXPECT_FLOAT_EQ(response.distance, route_planner.GetDistance());
+        if (request.type == RouteServer::Type::Route) {
+            EXPECT_EQ(response.path, model.path);
+        }
+    }
+}
+
+
+// Test that a version pinned by a reader outlives the publication of the next one, and is only
+// reclaimed once the reader lets go.
+TEST_F(ContractionHierarchyTest, TestRouteModelStore) {
+    RouteModelStore store{2};
+    auto make_version = [&] {
+        auto version = std::make_unique<RouteModelStore::Version>();
+        version->model = &model;
+        version->hierarchy = &hierarchy;
+        return version;
+    };
+    EXPECT_EQ(store.CurrentVersion(), 0);
+    EXPECT_EQ(store.Publish(make_version()), 1);
+    {
+        auto first = store.Read(0);
+        EXPECT_EQ(first->number, 1);
+        ASSERT_EQ(first->forward.size(), 2);
+        EXPECT_EQ(store.Publish(make_version()), 2);
+        EXPECT_EQ(store.CurrentVersion(), 2);
+        // A reader starting after the swap sees the new version and doesn't hold the old one.
+        {
+            auto second = store.Read(1);
+            EXPECT_EQ(second->number, 2);
+            EXPECT_FALSE(store.Reclaim());
+        }
+        EXPECT_FALSE(store.Reclaim());
+        // The old version stays usable for the query that pinned it.
+        auto search = first->hierarchy->Search(0, 0, first->forward[0], first->backward[0]);
+        EXPECT_EQ(search.distance, 0.0f);
+    }
+    EXPECT_TRUE(store.Reclaim());
+    auto current = store.Read(0);
+    EXPECT_EQ(current->number, 2);
+}
+
+
+// Test that the server keeps answering pipelined requests correctly while it reloads its map,
+// also from its route cache, and switches to the new model version.
+TEST_F(ContractionHierarchyTest, TestRouteServerReload) {
+    const std::string path = "/tmp/route_server_reload_test_" + std::to_string(getpid()) + ".sock";
+    RouteServer server{model, hierarchy, 2};
+    server.SetMapFiles(osm_data_file);
+    RouteCache cache{1 << 20};
+    server.SetCache(&cache);
+    ASSERT_TRUE(server.ListenUnix(path));
+    EXPECT_EQ(server.ModelVersion(), 1);
+    std::thread loop{[&] { server.Run(); }};
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    std::vector<float> expected;
+    for (const auto &query : queries) {
+        route_planner.SetEndpoints(query[0], query[1], query[2], query[3]);
+        route_planner.ContractionHierarchySearch(hierarchy);
+        expected.push_back(model.path.empty() ? -1.0f : route_planner.GetDistance());
+    }
+
+    // Rounds of pipelined requests before, during and after the reload.
+    server.Reload();
+    std::uint32_t id = 0;
+    bool reloaded = false;
+    for (int round = 0; round < 1000 && !reloaded; ++round) {
+        reloaded = server.ModelVersion() == 2 && !server.Reloading();
+        std::vector<std::byte> out;
+        for (const auto &query : queries) {
+            RouteServer::AppendRequest(out, {id++, RouteServer::Type::Distance, query[0], query[1], query[2], query[3]});
+        }
+        ASSERT_EQ(send(fd, out.data(), out.size(), 0), static_cast<ssize_t>(out.size()));
+        std::vector<std::byte> in;
+        for (std::size_t received = 0; received < queries.size();) {
+            std::array<std::byte, 4096> chunk;
+            ssize_t count = recv(fd, chunk.data(), chunk.size(), 0);
+            ASSERT_GT(count, 0);
+            in.insert(in.end(), chunk.begin(), chunk.begin() + count);
+            RouteServer::Response response;
+            while (long size = RouteServer::ParseResponse(in.data(), in.size(), response)) {
+                ASSERT_GT(size, 0);
+                const float distance = expected[response.id % queries.size()];
+                if (distance < 0.0f) {
+                    EXPECT_EQ(response.status, RouteServer::Status::NoRoute);
+                }
+                else {
+                    EXPECT_FLOAT_EQ(response.distance, distance);
+                }
+                in.erase(in.begin(), in.begin() + size);
+                ++received;
+            }
+        }
+        if (!reloaded) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    EXPECT_TRUE(reloaded);
+    // Repeated queries hit the cache, which the reload invalidated.
+    EXPECT_GT(cache.Hits(), 0);
+    EXPECT_EQ(cache.Version(), 1);
+    close(fd);
+    server.Stop();
+    loop.join();
 }